@@ -0,0 +1,370 @@
+/* Libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/wait.h>
+/* Libraries End*/
+
+/*
+ * Benchmark driver of the mess hall. Sweeps N, M, T, S, L and B over the given
+ * lists, runs ./program with --log=off --stats for every combination and
+ * collects its STATS line into <prefix>.csv and <prefix>.json. Event logging
+ * is switched off so the numbers show synchronization cost, not terminal I/O.
+ * Combinations the program rejects with a constraint error are skipped, so
+ * the constraints live in check_constraint() only. A run that does not end
+ * within the timeout is interrupted and recorded as failed, the sweep goes on.
+ */
+
+/* Macro Constants */
+#define BENCH_USE_ERR "Usage: ./bench [-N 3,6] [-M 24,96] [-T 4] [-S 4] [-L 3,6] [-B 1] [-m processes,threads,des] [-r repeats] [-p ./program] [-o bench] [-t seconds]\n"
+#define BENCH_TIMEOUT_S 60					//default time a run may take before it is interrupted
+#define BENCH_STOP_S 1.0					//time an interrupted run gets to exit before it is killed
+#define MAX_VALUES 32
+#define OUT_SIZE 8192
+#define TRUE 1
+#define FALSE 0
+#define RUN_OK 0
+#define RUN_FAILED 1						//the program failed or printed no STATS line
+#define RUN_REJECTED 2						//the program rejected the combination
+#define RUN_TIMEOUT 3						//the run was interrupted at the timeout
+/* Macro Constants End */
+
+/* Structs */
+struct Value_List
+{
+	int count;
+	int values[MAX_VALUES];
+};
+struct Result
+{
+	double wall_s;					//wall time seen by the bench, including startup
+	double run_s;					//wall time reported by the program
+	long plates;
+	double plates_per_s;
+	long trays;
+	double trays_per_s;
+	long meals;
+	double meals_per_s;
+	double supplier_util;
+	double cook_util;
+	double student_util;
+};
+/* Structs End */
+
+/* Typdefs */
+typedef struct Value_List Value_List;
+typedef struct Result Result;
+/* Typedefs End*/
+
+/* Function Declarations */
+void parse_list(const char*, Value_List*);
+void make_input(char*, const int, const int);
+int run_program(const char*, const char*, const char*, const int, const int, const int, const int, const int, const int,
+				const double, Result*);
+int wait_program(const pid_t, const double, int*);
+double find_value(const char*, const char*);
+double now_s(void);
+/* Function Declarations End */
+
+int main(int argc, char *argv[])
+{
+	Value_List N = {2, {3, 6}};
+	Value_List M = {2, {24, 96}};
+	Value_List T = {1, {4}};
+	Value_List S = {1, {4}};
+	Value_List L = {2, {3, 6}};
+	Value_List B = {1, {1}};
+	char *modes = "processes";
+	char *program = "./program";
+	char *prefix = "bench";
+	int repeats = 3;
+	double timeout = BENCH_TIMEOUT_S;
+
+	int option;
+	while((option = getopt(argc, argv, "N:M:T:S:L:B:m:r:p:o:t:")) != -1)
+	{
+		switch (option)
+		{
+		case 'N': parse_list(optarg, &N); break;
+		case 'M': parse_list(optarg, &M); break;
+		case 'T': parse_list(optarg, &T); break;
+		case 'S': parse_list(optarg, &S); break;
+		case 'L': parse_list(optarg, &L); break;
+		case 'B': parse_list(optarg, &B); break;
+		case 'm': modes = optarg; break;
+		case 'r': repeats = atoi(optarg); break;
+		case 'p': program = optarg; break;
+		case 'o': prefix = optarg; break;
+		case 't': timeout = atof(optarg); break;
+		default:
+			fprintf(stderr, BENCH_USE_ERR);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	char path[256];
+	snprintf(path, sizeof(path), "%s.csv", prefix);
+	FILE *csv = fopen(path, "w");
+	snprintf(path, sizeof(path), "%s.json", prefix);
+	FILE *json = fopen(path, "w");
+	if(csv == NULL || json == NULL)
+	{
+		perror("fopen");
+		exit(EXIT_FAILURE);
+	}
+	fprintf(csv, "mode,N,M,T,S,L,B,repeat,wall_s,run_s,plates,plates_per_s,trays,trays_per_s,meals,meals_per_s,supplier_util,cook_util,student_util\n");
+	fprintf(json, "[");
+
+	char mode_list[256];
+	snprintf(mode_list, sizeof(mode_list), "%s", modes);
+	int is_first = TRUE;
+	srand(1);
+	for(char *mode = strtok(mode_list, ","); mode != NULL; mode = strtok(NULL, ","))
+	for(int l = 0; l < L.count; l++)
+	for(int m = 0; m < M.count; m++)
+	{
+		char input[] = "/tmp/bench-input-XXXXXX";
+		make_input(input, M.values[m], L.values[l]);
+		for(int n = 0; n < N.count; n++)
+		for(int t = 0; t < T.count; t++)
+		for(int s = 0; s < S.count; s++)
+		for(int b = 0; b < B.count; b++)
+		{
+			for(int r = 0; r < repeats; r++)
+			{
+				Result res;
+				int run = run_program(program, mode, input, N.values[n], M.values[m], T.values[t], S.values[s], L.values[l],
+									  B.values[b], timeout, &res);
+				if(run == RUN_REJECTED)
+					break;
+				if(run != RUN_OK)
+				{
+					fprintf(stderr, "bench: %s N=%d M=%d T=%d S=%d L=%d B=%d %s\n", 
+							mode, N.values[n], M.values[m], T.values[t], S.values[s], L.values[l], B.values[b],
+							(run == RUN_TIMEOUT) ? "timed out" : "failed");
+					continue;
+				}
+				printf("%-9s N=%-3d M=%-6d T=%-4d S=%-3d L=%-3d B=%-3d #%d wall %.4fs plates/s %.0f trays/s %.0f meals/s %.0f util S/C/St %.2f/%.2f/%.2f\n",
+					   mode, N.values[n], M.values[m], T.values[t], S.values[s], L.values[l], B.values[b], r, res.wall_s,
+					   res.plates_per_s, res.trays_per_s, res.meals_per_s, res.supplier_util, res.cook_util, res.student_util);
+				fprintf(csv, "%s,%d,%d,%d,%d,%d,%d,%d,%.6f,%.6f,%ld,%.1f,%ld,%.1f,%ld,%.1f,%.4f,%.4f,%.4f\n",
+						mode, N.values[n], M.values[m], T.values[t], S.values[s], L.values[l], B.values[b], r, res.wall_s, res.run_s,
+						res.plates, res.plates_per_s, res.trays, res.trays_per_s, res.meals, res.meals_per_s,
+						res.supplier_util, res.cook_util, res.student_util);
+				fprintf(json, "%s\n  {\"mode\": \"%s\", \"N\": %d, \"M\": %d, \"T\": %d, \"S\": %d, \"L\": %d, \"B\": %d, \"repeat\": %d, "
+						"\"wall_s\": %.6f, \"run_s\": %.6f, \"plates\": %ld, \"plates_per_s\": %.1f, \"trays\": %ld, \"trays_per_s\": %.1f, "
+						"\"meals\": %ld, \"meals_per_s\": %.1f, \"supplier_util\": %.4f, \"cook_util\": %.4f, \"student_util\": %.4f}",
+						is_first ? "" : ",", mode, N.values[n], M.values[m], T.values[t], S.values[s], L.values[l], B.values[b], r,
+						res.wall_s, res.run_s, res.plates, res.plates_per_s, res.trays, res.trays_per_s,
+						res.meals, res.meals_per_s, res.supplier_util, res.cook_util, res.student_util);
+				is_first = FALSE;
+			}
+		}
+		unlink(input);
+	}
+
+	fprintf(json, "\n]\n");
+	fclose(csv);
+	fclose(json);
+	return 0;
+}
+
+void parse_list(const char *arg, Value_List *list)
+{
+	list->count = 0;
+	const char *pos = arg;
+	while(*pos != '\0' && list->count < MAX_VALUES)
+	{
+		list->values[list->count++] = atoi(pos);
+		pos += strcspn(pos, ",");
+		if(*pos == ',')
+			pos++;
+	}
+}
+
+void make_input(char *path, const int M, const int L)
+{
+	int fd = mkstemp(path);
+	if(fd == -1)
+	{
+		perror("mkstemp");
+		exit(EXIT_FAILURE);
+	}
+	size_t count = 3 * (size_t)L * M;
+	char *plates = malloc(count);
+	for(size_t i = 0; i < count; i++)
+		plates[i] = "PCD"[i % 3];
+	for(size_t i = count - 1; i > 0; i--)
+	{
+		size_t j = rand() % (i + 1);
+		char tmp = plates[i];
+		plates[i] = plates[j];
+		plates[j] = tmp;
+	}
+	if(write(fd, plates, count) != (ssize_t)count)
+	{
+		perror("write");
+		exit(EXIT_FAILURE);
+	}
+	free(plates);
+	close(fd);
+}
+
+int run_program(const char *program, const char *mode, const char *input, 
+				const int N, const int M, const int T, const int S, const int L, const int B, const double timeout,
+				Result *res)
+{
+	int fds[2];
+	if(pipe(fds) == -1)
+	{
+		perror("pipe");
+		exit(EXIT_FAILURE);
+	}
+
+	char args[6][16];
+	snprintf(args[0], sizeof(args[0]), "%d", N);
+	snprintf(args[1], sizeof(args[1]), "%d", M);
+	snprintf(args[2], sizeof(args[2]), "%d", T);
+	snprintf(args[3], sizeof(args[3]), "%d", S);
+	snprintf(args[4], sizeof(args[4]), "%d", L);
+	snprintf(args[5], sizeof(args[5]), "%d", B);
+	char mode_arg[64];
+	/* des is an engine rather than an actor backend */
+	if(strcmp(mode, "des") == 0)
+		snprintf(mode_arg, sizeof(mode_arg), "--engine=des");
+	else
+		snprintf(mode_arg, sizeof(mode_arg), "--mode=%s", mode);
+
+	double begin = now_s();
+	pid_t pid = fork();
+	if(pid == -1)
+	{
+		perror("fork");
+		exit(EXIT_FAILURE);
+	}
+	if(pid == 0)
+	{
+		int null_fd = open("/dev/null", O_WRONLY);
+		dup2(null_fd, STDOUT_FILENO);
+		dup2(fds[1], STDERR_FILENO);
+		close(fds[0]);
+		close(fds[1]);
+		execl(program, program, "-N", args[0], "-M", args[1], "-T", args[2], "-S", args[3], "-L", args[4],
+			  "-B", args[5], "-F", input, "--log=off", "--stats", mode_arg, (char*)NULL);
+		_exit(127);
+	}
+	close(fds[1]);
+
+	/*
+	 * The actors keep the pipe open too, a stalled run never closes it. The
+	 * pipe is drained until EOF so a long report never blocks the program or
+	 * kills it with SIGPIPE; only the STATS line and a constraint error are
+	 * kept from it.
+	 */
+	double deadline = begin + timeout;
+	char out[OUT_SIZE];
+	char stats[OUT_SIZE] = "";
+	int is_rejected = FALSE;
+	size_t len = 0;
+	for(;;)
+	{
+		struct pollfd pfd = {fds[0], POLLIN, 0};
+		int left_ms = (int)((deadline - now_s()) * 1000);
+		int ready = (left_ms > 0) ? poll(&pfd, 1, left_ms) : 0;
+		if(ready == -1 && errno == EINTR)
+			continue;
+		if(ready <= 0)
+			break;
+		ssize_t got = read(fds[0], out + len, sizeof(out) - 1 - len);
+		if(got == -1 && errno == EINTR)
+			continue;
+		if(got <= 0)
+			break;
+		len += got;
+		out[len] = '\0';
+
+		char *line = out;
+		char *end;
+		while((end = strchr(line, '\n')) != NULL)
+		{
+			*end = '\0';
+			if(strncmp(line, "STATS ", 6) == 0)
+				snprintf(stats, sizeof(stats), "%s", line);
+			if(strstr(line, "Error! Constraint") != NULL)
+				is_rejected = TRUE;
+			line = end + 1;
+		}
+		/* a line longer than the buffer is none of the two and is dropped */
+		len = (line == out && len == sizeof(out) - 1) ? 0 : (size_t)(out + len - line);
+		memmove(out, line, len);
+	}
+	close(fds[0]);
+
+	int status = 0;
+	int is_done = wait_program(pid, deadline, &status);
+	res->wall_s = now_s() - begin;
+	if(!is_done)
+		return RUN_TIMEOUT;
+
+	if(WIFEXITED(status) && WEXITSTATUS(status) != 0 && is_rejected)
+		return RUN_REJECTED;
+	if(!WIFEXITED(status) || WEXITSTATUS(status) != 0 || stats[0] == '\0')
+		return RUN_FAILED;
+
+	res->run_s = find_value(stats, "wall_s");
+	res->plates = find_value(stats, "plates");
+	res->plates_per_s = find_value(stats, "plates_per_s");
+	res->trays = find_value(stats, "trays");
+	res->trays_per_s = find_value(stats, "trays_per_s");
+	res->meals = find_value(stats, "meals");
+	res->meals_per_s = find_value(stats, "meals_per_s");
+	res->supplier_util = find_value(stats, "supplier_util");
+	res->cook_util = find_value(stats, "cook_util");
+	res->student_util = find_value(stats, "student_util");
+	return RUN_OK;
+}
+
+/* waits for the program until the deadline, FALSE if it had to be interrupted */
+int wait_program(const pid_t pid, const double deadline, int *status)
+{
+	struct timespec tick = {0, 10000000};
+	while(now_s() < deadline)
+	{
+		pid_t done = waitpid(pid, status, WNOHANG);
+		if(done == pid || (done == -1 && errno != EINTR))
+			return TRUE;
+		nanosleep(&tick, NULL);
+	}
+	/* SIGINT makes the program kill its actors, which are in a process group of their own */
+	kill(pid, SIGINT);
+	double stop = now_s() + BENCH_STOP_S;
+	while(waitpid(pid, status, WNOHANG) == 0 && now_s() < stop)
+		nanosleep(&tick, NULL);
+	if(kill(pid, SIGKILL) == 0)
+		waitpid(pid, status, 0);
+	return FALSE;
+}
+
+double find_value(const char *line, const char *key)
+{
+	size_t key_len = strlen(key);
+	for(const char *pos = line; (pos = strstr(pos, key)) != NULL; pos += key_len)
+	{
+		if((pos == line || pos[-1] == ' ') && pos[key_len] == '=')
+			return atof(pos + key_len + 1);
+	}
+	return 0;
+}
+
+double now_s(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
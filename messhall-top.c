@@ -0,0 +1,292 @@
+/* Libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <ctype.h>
+#include "program-metrics.h"
+/* Libraries End*/
+
+/*
+ * Monitor of a run started with ./program --metrics. Every run, and every
+ * hall of a --halls run, publishes METRICS_SEG-<pid>; the monitor takes a pid
+ * or a segment name and otherwise watches the newest one. It maps the segment
+ * read-only and prints one TOP line per interval with the totals, their rates
+ * over the interval and the kitchen, counter and table gauges; with -a also an
+ * ACTORS line with the progress of the roles and the actor that waited most.
+ * The run is never written to, so attaching and detaching does not disturb it.
+ * Exits when the run is done or its process is gone.
+ */
+
+/* Macro Constants */
+#define TOP_USE_ERR "Usage: ./messhall-top [-i seconds] [-n count] [-a] [-w] [PID|SEGMENT]\n"
+#define TOP_SHM_DIR "/dev/shm"
+#define TOP_ATTACH_NS 100000000LL			//retry period of -w and of a header still being written
+#define TRUE 1
+#define FALSE 0
+/* Macro Constants End */
+
+/* Global Variables */
+static const char *state_names[] = {"starting", "running", "done"};
+static const char *role_names[ROLE_COUNT] = {"Supplier", "Cook", "Student"};
+/* Global Variables End */
+
+/* Function Declarations */
+void top_sleep(const long long);
+int top_find(char*, const size_t);
+const Hall_Metrics *top_attach(const char*, const int);
+void top_read(const Hall_Metrics*, Metrics_Sample*);
+void top_print(const Hall_Metrics*, const Metrics_Sample*, const Metrics_Sample*);
+void top_print_actors(const Hall_Metrics*);
+/* Function Declarations End */
+
+int main(int argc, char *argv[])
+{
+	double interval = 1.0;
+	long count = -1;
+	int show_actors = FALSE;
+	int is_waiting = FALSE;
+
+	int option;
+	while((option = getopt(argc, argv, "i:n:aw")) != -1)
+	{
+		switch (option)
+		{
+		case 'i':
+			interval = atof(optarg);
+			break;
+		case 'n':
+			count = atol(optarg);
+			break;
+		case 'a':
+			show_actors = TRUE;
+			break;
+		case 'w':
+			is_waiting = TRUE;
+			break;
+		default:
+			fprintf(stderr, TOP_USE_ERR);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if(interval <= 0 || optind + 1 < argc)
+	{
+		fprintf(stderr, TOP_USE_ERR);
+		exit(EXIT_FAILURE);
+	}
+	char name[METRICS_NAME_SIZE];
+	if(optind == argc)
+	{
+		while(!top_find(name, sizeof(name)))
+		{
+			if(!is_waiting)
+			{
+				fprintf(stderr, "messhall-top: no run with --metrics in progress!\n");
+				exit(EXIT_FAILURE);
+			}
+			top_sleep(TOP_ATTACH_NS);
+		}
+	}
+	else if(isdigit((unsigned char)argv[optind][0]))
+		snprintf(name, sizeof(name), METRICS_SEG "-%s", argv[optind]);
+	else
+		snprintf(name, sizeof(name), "%s", argv[optind]);
+
+	const Hall_Metrics *metrics = top_attach(name, is_waiting);
+	printf("HALL hall=%d pid=%d mode=%s N=%d M=%d T=%d S=%d L=%d K=%d actors=%d\n", metrics->hall, (int)metrics->pid,
+		   (metrics->mode == MODE_THREADS) ? "threads" : "processes", metrics->N, metrics->M, metrics->T,
+		   metrics->S, metrics->L, metrics->K, metrics->actors);
+
+	Metrics_Sample last;
+	top_read(metrics, &last);
+	for(long i = 0; count < 0 || i < count; i++)
+	{
+		top_sleep((long long)(interval * 1e9));
+		int state = atomic_load(&metrics->state);
+		Metrics_Sample now;
+		top_read(metrics, &now);
+		top_print(metrics, &last, &now);
+		if(show_actors)
+			top_print_actors(metrics);
+		fflush(stdout);
+		last = now;
+
+		if(state == METRICS_DONE)
+			break;
+		if(kill(metrics->pid, 0) == -1 && errno == ESRCH)
+		{
+			fprintf(stderr, "messhall-top: the run ended before it was done!\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+void top_sleep(const long long ns)
+{
+	struct timespec ts = {ns / 1000000000LL, ns % 1000000000LL};
+	while(nanosleep(&ts, &ts) == -1 && errno == EINTR);
+}
+
+/* newest metrics segment in /dev/shm, FALSE if there is none */
+int top_find(char *name, const size_t size)
+{
+	DIR *dir = opendir(TOP_SHM_DIR);
+	if(dir == NULL)
+		return FALSE;
+	const char *prefix = METRICS_SEG + 1;
+	size_t prefix_len = strlen(prefix);
+	int found = 0;
+	struct timespec newest = {0, 0};
+	struct dirent *entry;
+	while((entry = readdir(dir)) != NULL)
+	{
+		if(strncmp(entry->d_name, prefix, prefix_len) != 0 || entry->d_name[prefix_len] != '-')
+			continue;
+		char path[512];
+		struct stat st;
+		snprintf(path, sizeof(path), TOP_SHM_DIR "/%s", entry->d_name);
+		if(stat(path, &st) == -1)
+			continue;
+		if(found == 0 || st.st_mtim.tv_sec > newest.tv_sec ||
+		   (st.st_mtim.tv_sec == newest.tv_sec && st.st_mtim.tv_nsec > newest.tv_nsec))
+		{
+			newest = st.st_mtim;
+			snprintf(name, size, "/%s", entry->d_name);
+		}
+		found++;
+	}
+	closedir(dir);
+	if(found > 1)
+		fprintf(stderr, "messhall-top: %d runs publish metrics, watching the newest, %s\n", found, name);
+	return found > 0;
+}
+
+const Hall_Metrics *top_attach(const char *name, const int is_waiting)
+{
+	int fd;
+	while((fd = shm_open(name, O_RDONLY, 0)) == -1)
+	{
+		if(!is_waiting || errno != ENOENT)
+		{
+			fprintf(stderr, "shm_open(): unsuccessful for %s, is a run with --metrics in progress?\n", name);
+			exit(EXIT_FAILURE);
+		}
+		top_sleep(TOP_ATTACH_NS);
+	}
+
+	/* the run sizes the segment before it writes the header, magic comes last */
+	struct stat st;
+	const Hall_Metrics *metrics = NULL;
+	for(int tries = 0; metrics == NULL; tries++)
+	{
+		if(fstat(fd, &st) == -1)
+		{
+			fprintf(stderr, "fstat(): unsuccessful for %s!\n", name);
+			exit(EXIT_FAILURE);
+		}
+		if((size_t)st.st_size >= sizeof(Hall_Metrics))
+		{
+			const Hall_Metrics *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+			if(map == MAP_FAILED)
+			{
+				fprintf(stderr, "mmap(): unsuccessful for %s!\n", name);
+				exit(EXIT_FAILURE);
+			}
+			if(map->magic == METRICS_MAGIC && sizeof(Hall_Metrics) + (size_t)map->actors * sizeof(Metrics_Actor) <= (size_t)st.st_size)
+				metrics = map;
+			else
+				munmap((void *)map, st.st_size);
+		}
+		if(metrics == NULL)
+		{
+			if(tries == 50)
+			{
+				fprintf(stderr, "messhall-top: %s is not a metrics segment of this version!\n", name);
+				exit(EXIT_FAILURE);
+			}
+			top_sleep(TOP_ATTACH_NS);
+		}
+	}
+	atomic_thread_fence(memory_order_acquire);
+	close(fd);
+	return metrics;
+}
+
+void top_read(const Hall_Metrics *metrics, Metrics_Sample *sample)
+{
+	/* sequence lock of the sampler: copy while seq is even and did not move */
+	unsigned int seq;
+	do
+	{
+		while((seq = atomic_load_explicit(&metrics->seq, memory_order_acquire)) & 1);
+		memcpy(sample, (const void *)&metrics->sample, sizeof(Metrics_Sample));
+		atomic_thread_fence(memory_order_acquire);
+	} while(atomic_load_explicit(&metrics->seq, memory_order_relaxed) != seq);
+}
+
+void top_print(const Hall_Metrics *metrics, const Metrics_Sample *last, const Metrics_Sample *now)
+{
+	double dt = (now->time_ns - last->time_ns) / 1e9;
+	if(dt <= 0)
+		dt = 1e-9;
+	int state = atomic_load(&metrics->state);
+	printf("TOP t_s=%.1f state=%s delivered=%lld plates_per_s=%.0f served=%lld trays=%lld trays_per_s=%.0f "
+		   "meals=%lld meals_per_s=%.0f kitchen=%lld/%d counter=%lld at_counter=%lld tables_busy=%lld/%d "
+		   "wait_s=%.3f/%.3f/%.3f done=%lld/%d\n",
+		   now->time_ns / 1e9, state_names[state], now->plates_delivered,
+		   (now->plates_delivered - last->plates_delivered) / dt, now->plates_served, now->trays_taken,
+		   (now->trays_taken - last->trays_taken) / dt, now->meals, (now->meals - last->meals) / dt,
+		   now->kitchen_plates, metrics->K, now->counter_plates, now->at_counter, now->tables_busy, metrics->T,
+		   now->wait_ns[ROLE_SUPPLIER] / 1e9, now->wait_ns[ROLE_COOK] / 1e9, now->wait_ns[ROLE_STUDENT] / 1e9,
+		   now->actors_done, metrics->actors);
+}
+
+void top_print_actors(const Hall_Metrics *metrics)
+{
+	long long min[ROLE_COUNT];
+	long long max[ROLE_COUNT];
+	int states[METRICS_DONE + 1] = {0, 0, 0};
+	int top = 0;
+	long long top_wait = -1;
+	for(int role = 0; role < ROLE_COUNT; role++)
+	{
+		min[role] = -1;
+		max[role] = -1;
+	}
+	for(int i = 0; i < metrics->actors; i++)
+	{
+		const Metrics_Actor *actor = &metrics->actor[i];
+		int role = actor->role;
+		long long progress = atomic_load_explicit(&actor->progress, memory_order_relaxed);
+		long long wait_ns = atomic_load_explicit(&actor->wait_ns, memory_order_relaxed);
+		int state = atomic_load_explicit(&actor->state, memory_order_relaxed);
+		if(state >= METRICS_STARTING && state <= METRICS_DONE)
+			states[state]++;
+		if(min[role] == -1 || progress < min[role])
+			min[role] = progress;
+		if(progress > max[role])
+			max[role] = progress;
+		if(wait_ns > top_wait)
+		{
+			top_wait = wait_ns;
+			top = i;
+		}
+	}
+
+	/* actor i is the supplier for 0, cook i up to N, student i % M after that, as in run_actor() */
+	int top_role = metrics->actor[top].role;
+	int top_number = (top_role == ROLE_STUDENT) ? top % metrics->M : top;
+	printf("ACTORS starting=%d running=%d done=%d supplier=%lld cook_min=%lld cook_max=%lld student_min=%lld "
+		   "student_max=%lld most_wait=\"%s %d\" most_wait_s=%.3f\n",
+		   states[METRICS_STARTING], states[METRICS_RUNNING], states[METRICS_DONE], max[ROLE_SUPPLIER],
+		   min[ROLE_COOK], max[ROLE_COOK], min[ROLE_STUDENT], max[ROLE_STUDENT], role_names[top_role], top_number,
+		   top_wait / 1e9);
+}
@@ -0,0 +1,403 @@
+/* Libraries */
+#include "program-des.h"
+#include "program-events.h"
+#include "program-input.h"
+#include "program-menu.h"
+#include "program-stats.h"
+#include "program-trace.h"
+#include "program-utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+/* Libraries End*/
+
+/*
+ * Discrete event simulation of the mess hall on one core. Every actor is a
+ * small state machine; an actor has at most one pending event, kept in a
+ * binary heap ordered by virtual time. Blocking is a queue instead of a
+ * semaphore: the actor that frees the resource schedules the waiter. The
+ * rules are those of the actor engine (kitchen of K plates, trays admitted
+ * S / courses at a time, cooks take whichever course the counter can use,
+ * trays go to the oldest waiting student of the first priority class) with
+ * one counter shard and one plate per cook trip, and every step costs the
+ * fixed DES_*_NS time.
+ */
+
+/* Global Variables */
+static int n_cooks, n_students, n_places, n_rounds, n_kitchen, n_courses, n_classes;
+static Table_Set *des_tables;
+static Plate_Input des_input;
+static Des_Actor *actors;					//supplier, cooks, students
+static Des_Event *heap;						//pending events, one per actor at most
+static int heap_len;
+static long long heap_seq;
+static int kitchen[MENU_MAX];			//plates of each course in the kitchen
+static int course_taken[MENU_MAX];		//plates of each course claimed by cooks
+static int counter[MENU_MAX];			//plates of each course on the counter
+static int delivered;						//plates delivered by the supplier
+static int trays;							//complete trays on the counter
+static int ready;							//complete trays no student claimed yet
+static int taken;							//trays taken by students
+static int at_counter;						//students at the counter
+static long long meals;						//meals eaten
+static int is_supplier_blocked;				//supplier waits for space in the kitchen
+static int *idle_cooks;						//cooks waiting for a plate they can take
+static int idle_len;
+static int *tray_queue;						//students waiting for a tray, a ring of M per class
+static int tray_head[PRIORITY_MAX], tray_len[PRIORITY_MAX];
+static int *table_queue;					//students waiting for a table, first in first out
+static int table_head, table_len;
+/* Global Variables End */
+
+static void *des_alloc(const size_t count, const size_t size)
+{
+	void *mem = calloc(count, size);
+	if(mem == NULL)
+	{
+		char *err_msg = "calloc(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	return mem;
+}
+
+static int event_before(const Des_Event *a, const Des_Event *b)
+{
+	return (a->time != b->time) ? a->time < b->time : a->seq < b->seq;
+}
+
+static void schedule(const int actor, const int state, const long long time)
+{
+	actors[actor].state = state;
+	Des_Event event = {time, heap_seq++, actor};
+	int i = heap_len++;
+	while(i > 0 && event_before(&event, &heap[(i - 1) / 2]))
+	{
+		heap[i] = heap[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	heap[i] = event;
+}
+
+static Des_Event next_event(void)
+{
+	Des_Event top = heap[0];
+	Des_Event last = heap[--heap_len];
+	int i = 0;
+	for(;;)
+	{
+		int child = 2 * i + 1;
+		if(child >= heap_len)
+			break;
+		if(child + 1 < heap_len && event_before(&heap[child + 1], &heap[child]))
+			child++;
+		if(!event_before(&heap[child], &last))
+			break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = last;
+	return top;
+}
+
+static void block(const int actor, const long long now)
+{
+	if(actors[actor].wait_start < 0)
+		actors[actor].wait_start = now;
+}
+
+static void unblock(const int actor, const int point, const long long now)
+{
+	stats_record(point, (actors[actor].wait_start < 0) ? 0 : now - actors[actor].wait_start);
+	actors[actor].wait_start = -1;
+}
+
+static int kitchen_total(void)
+{
+	int total = 0;
+	for(int course = 0; course < n_courses; course++)
+		total += kitchen[course];
+	return total;
+}
+
+static void wake_cooks(int count, const long long now)
+{
+	/* idle cooks are alike, waking one per plate that became claimable is enough */
+	for(; idle_len > 0 && count > 0; idle_len--, count--)
+		schedule(idle_cooks[idle_len - 1], DES_COOK_LOOK, now);
+}
+
+static void sit(const int actor, const int table, const long long now)
+{
+	actors[actor].item = table;
+	event_student_sat(actor % n_students, table, actors[actor].round, tables_empty(des_tables));
+	meals++;
+	atomic_fetch_add_explicit(&run_stats->meals, 1, memory_order_relaxed);
+	schedule(actor, DES_STUDENT_LEAVE, now + DES_EAT_NS);
+}
+
+static void supplier_step(const long long now)
+{
+	Des_Actor *supplier = &actors[0];
+	if(supplier->state == DES_SUPPLIER_NEXT)
+	{
+		if(delivered == n_courses * n_rounds * n_students)
+		{
+			input_close(&des_input);
+			event_supplier_done();
+			supplier->state = DES_DONE;
+			return;
+		}
+		int status = input_next(&des_input, &supplier->item);
+		if(status == PLATE_END)
+		{
+			char *err_msg = "Not enough plates in the input!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
+			exit(EXIT_FAILURE);
+		}
+		if(status == PLATE_INVALID)
+		{
+			char *err_msg = "Invalid plate type!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
+			exit(EXIT_FAILURE);
+		}
+		event_supplier_going(supplier->item, kitchen);
+		if(kitchen_total() == n_kitchen)
+		{
+			is_supplier_blocked = TRUE;
+			supplier->state = DES_SUPPLIER_DELIVER;
+			block(0, now);
+			return;
+		}
+		unblock(0, WAIT_SUPPLIER_EMPTY, now);
+		schedule(0, DES_SUPPLIER_DELIVER, now + DES_DELIVER_NS);
+		return;
+	}
+
+	kitchen[supplier->item]++;
+	delivered++;
+	atomic_fetch_add_explicit(&run_stats->plates_delivered, 1, memory_order_relaxed);
+	event_supplier_delivered(supplier->item, kitchen);
+	wake_cooks(1, now);
+	schedule(0, DES_SUPPLIER_NEXT, now);
+}
+
+static int claim_course(int *is_done)
+{
+	/* same rule as claim_plate(): least claimed course first, only for trays with a place */
+	int best = -1;
+	*is_done = TRUE;
+	for(int course = 0; course < n_courses; course++)
+	{
+		if(course_taken[course] == n_rounds * n_students)
+			continue;
+		*is_done = FALSE;
+		if(kitchen[course] > 0 && course_taken[course] < taken + n_places / n_courses &&
+		   (best == -1 || course_taken[course] < course_taken[best]))
+			best = course;
+	}
+	return best;
+}
+
+static void cook_step(const int actor, const long long now)
+{
+	Des_Actor *cook = &actors[actor];
+	if(cook->state == DES_COOK_LOOK)
+	{
+		if(cook->wait_start < 0)
+			event_cook_kitchen(actor, kitchen);
+		int is_done;
+		int course = claim_course(&is_done);
+		if(is_done)
+		{
+			wake_cooks(n_cooks, now);
+			event_cook_done(actor, kitchen_total());
+			cook->state = DES_DONE;
+			return;
+		}
+		if(course == -1)
+		{
+			block(actor, now);
+			idle_cooks[idle_len++] = actor;
+			return;
+		}
+		if(cook->wait_start >= 0)
+			unblock(actor, WAIT_COOK_PLATE, now);
+
+		kitchen[course]--;
+		course_taken[course]++;
+		cook->item = course;
+		if(is_supplier_blocked)
+		{
+			is_supplier_blocked = FALSE;
+			unblock(0, WAIT_SUPPLIER_EMPTY, now);
+			schedule(0, DES_SUPPLIER_DELIVER, now + DES_DELIVER_NS);
+		}
+		schedule(actor, DES_COOK_PLACE, now + DES_KITCHEN_NS);
+		return;
+	}
+
+	event_cook_going(actor, cook->item, counter);
+	counter[cook->item]++;
+	event_cook_placed(actor, cook->item, counter);
+	atomic_fetch_add_explicit(&run_stats->plates_served, 1, memory_order_relaxed);
+	int is_tray = TRUE;
+	for(int course = 0; course < n_courses; course++)
+		is_tray = is_tray && counter[course] > trays;
+	if(is_tray)
+	{
+		trays++;
+		int class = 0;
+		while(class < n_classes && tray_len[class] == 0)
+			class++;
+		if(class < n_classes)
+		{
+			int student = tray_queue[class * n_students + tray_head[class]];
+			tray_head[class] = (tray_head[class] + 1) % n_students;
+			tray_len[class]--;
+			unblock(student, WAIT_STUDENT_TRAY, now);
+			schedule(student, DES_STUDENT_TRAY, now + DES_TRAY_NS);
+		}
+		else
+			ready++;
+	}
+	schedule(actor, DES_COOK_LOOK, now);
+}
+
+static void student_step(const int actor, const long long now)
+{
+	Des_Actor *student = &actors[actor];
+	int number = actor % n_students;
+	if(student->state == DES_STUDENT_ARRIVE)
+	{
+		student->round++;
+		student->arrive_ns = now;
+		at_counter++;
+		event_student_counter(number, student->round, at_counter, counter);
+		if(ready == 0)
+		{
+			block(actor, now);
+			int class = number % n_classes;
+			tray_queue[class * n_students + (tray_head[class] + tray_len[class]++) % n_students] = actor;
+			return;
+		}
+		ready--;
+		unblock(actor, WAIT_STUDENT_TRAY, now);
+		schedule(actor, DES_STUDENT_TRAY, now + DES_TRAY_NS);
+		return;
+	}
+
+	if(student->state == DES_STUDENT_TRAY)
+	{
+		for(int course = 0; course < n_courses; course++)
+			counter[course]--;
+		trays--;
+		taken++;
+		at_counter--;
+		atomic_fetch_add_explicit(&run_stats->trays_taken, 1, memory_order_relaxed);
+		stats_span(WAIT_STUDENT_SERVED + number % n_classes, now - student->arrive_ns);
+		event_student_got(number, student->round, tables_empty(des_tables));
+		wake_cooks(n_courses, now);
+
+		int table = table_take(des_tables, number, now);
+		if(table == -1)
+		{
+			block(actor, now);
+			table_queue[(table_head + table_len++) % n_students] = actor;
+			return;
+		}
+		unblock(actor, WAIT_STUDENT_TABLE, now);
+		sit(actor, table, now);
+		return;
+	}
+
+	table_put(des_tables, student->item, now);
+	if(table_len > 0)
+	{
+		int next = table_queue[table_head];
+		table_head = (table_head + 1) % n_students;
+		table_len--;
+		unblock(next, WAIT_STUDENT_TABLE, now);
+		sit(next, table_take(des_tables, next % n_students, now), now);
+	}
+	if(student->round < n_rounds)
+	{
+		event_student_left(number, student->item, student->round, tables_empty(des_tables));
+		schedule(actor, DES_STUDENT_ARRIVE, now);
+	}
+	else
+	{
+		event_student_done(number, student->round);
+		student->state = DES_DONE;
+	}
+}
+
+int des_run(Table_Set *tables, const char *input_path, const long long first, const long long count, const int N,
+		const int M, const int S, const int L, const int K, const int classes)
+{
+	n_cooks = N;
+	n_students = M;
+	n_places = S;
+	n_rounds = L;
+	n_kitchen = K;
+	n_courses = menu.count;
+	n_classes = classes;
+	des_tables = tables;
+	if(!input_open(&des_input, input_path))
+	{
+		char *err_msg = "open(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	input_slice(&des_input, first, count);
+
+	int actor_count = N + M + 1;
+	actors = des_alloc(actor_count, sizeof(Des_Actor));
+	heap = des_alloc(actor_count, sizeof(Des_Event));
+	idle_cooks = des_alloc(N, sizeof(int));
+	tray_queue = des_alloc((size_t)classes * M, sizeof(int));
+	table_queue = des_alloc(M, sizeof(int));
+	for(int i = 0; i < actor_count; i++)
+	{
+		actors[i].wait_start = -1;
+		schedule(i, (i == 0) ? DES_SUPPLIER_NEXT : (i <= N) ? DES_COOK_LOOK : DES_STUDENT_ARRIVE, 0);
+	}
+
+	long long now = 0;
+	run_stats->start_ns = 0;
+	trace_open(0);
+	while(heap_len > 0)
+	{
+		Des_Event event = next_event();
+		now = event.time;
+		trace_set_time(now);
+		if(event.actor == 0)
+			supplier_step(now);
+		else if(event.actor <= N)
+			cook_step(event.actor, now);
+		else
+			student_step(event.actor, now);
+	}
+	run_stats->end_ns = now;
+	trace_close();
+	stats_actor_end();
+
+	free(actors);
+	free(heap);
+	free(idle_cooks);
+	free(tray_queue);
+	free(table_queue);
+	if(meals != (long long)L * M && is_supplier_blocked)
+	{
+		char *err_msg = "The kitchen is full of plates the counter cannot take, the input needs a larger -K!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		return EXIT_FAILURE;
+	}
+	if(meals != (long long)L * M)
+	{
+		char *err_msg = "des: no event left before every meal was eaten!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,55 @@
+#ifndef PROGRAM_DES_H
+#define PROGRAM_DES_H
+
+/* Libraries */
+#include "program-tables.h"
+/* Libraries End*/
+
+/* Macro Constants */
+#define DES_DELIVER_NS 1000					//supplier carries a plate into the kitchen
+#define DES_KITCHEN_NS 2000					//cook carries a plate from the kitchen to the counter
+#define DES_TRAY_NS 500						//student takes a tray from the counter
+#define DES_EAT_NS 60000					//student eats at a table
+/* Macro Constants End */
+
+/* Enums */
+enum Des_State
+{
+	DES_SUPPLIER_NEXT,						//supplier reads the next plate of the input
+	DES_SUPPLIER_DELIVER,					//supplier puts the plate into the kitchen
+	DES_COOK_LOOK,							//cook looks for a plate it can take
+	DES_COOK_PLACE,							//cook puts its plate on the counter
+	DES_STUDENT_ARRIVE,						//student comes to the counter
+	DES_STUDENT_TRAY,						//student takes a tray
+	DES_STUDENT_LEAVE,						//student finished eating
+	DES_DONE								//actor went home
+};
+/* Enums End */
+
+/* Structs */
+struct Des_Event
+{
+	long long time;							//virtual time of the event in ns
+	long long seq;							//order of scheduling, breaks ties first in first out
+	int actor;								//0 supplier, 1..N cooks, then students
+};
+struct Des_Actor
+{
+	int state;								//next step of the actor, a Des_State
+	int item;								//course carried by supplier or cook, table of a student
+	int round;								//meals started by a student
+	long long wait_start;					//when the actor blocked, -1 if it is not blocked
+	long long arrive_ns;					//when a student went to the counter
+};
+/* Structs End */
+
+/* Typdefs */
+typedef struct Des_Event Des_Event;
+typedef struct Des_Actor Des_Actor;
+/* Typedefs End*/
+
+/* Function Definitions */
+int des_run(Table_Set*, const char*, const long long, const long long, const int, const int, const int, const int, const int, const int);
+/* Function Definitions End*/
+
+#endif
@@ -0,0 +1,187 @@
+/* Libraries */
+#include "program-events.h"
+#include "program-log.h"
+#include <stdio.h>
+#include <string.h>
+/* Libraries End*/
+
+/*
+ * Text of every event of the mess hall. Both the actor engine and the
+ * simulation engine report through these functions, so their output can be
+ * compared line by line. Courses are numbered in menu order, see
+ * program-menu.c; items are the count of each course the actor saw, printed
+ * as "P:1,C:0,D:2=3" with the plate codes of the menu. Each event is one
+ * Trace_Record, written to the binary trace and formatted by event_format(),
+ * which the trace decoder shares to reproduce the text. Under --halls every
+ * line starts with the hall, the trace keeps one directory per hall instead.
+ */
+
+/* Global Variables */
+static int event_hall = -1;					//hall of this process under --halls, -1 for a single hall
+/* Global Variables End */
+
+int event_format(const Trace_Record *e, char *buf, const size_t size)
+{
+	int len;
+	char items[MENU_MAX * 16] = "";
+	if(e->role != TRACE_STUDENT || e->code == TRACE_STUDENT_COUNTER)
+		menu_items(e->items, items, sizeof(items));
+	const char *course = menu.name[e->course % menu.count];
+	switch (e->code)
+	{
+	case TRACE_SUPPLIER_GOING:
+		len = snprintf(buf, size, "The supplier is going to the kitchen to deliver %s: kitchen items %s\n",
+				course, items);
+		break;
+	case TRACE_SUPPLIER_DELIVERED:
+		len = snprintf(buf, size, "The supplier delivered %s - after delivery: kitchen items %s\n",
+				course, items);
+		break;
+	case TRACE_SUPPLIER_DONE:
+		len = snprintf(buf, size, "The supplier finished supplying - GOODBYE!\n");
+		break;
+	case TRACE_COOK_KITCHEN:
+		len = snprintf(buf, size, "Cook %d going to the kitchen to wait for/get a plate - kitchen items %s\n",
+				e->number, items);
+		break;
+	case TRACE_COOK_GOING:
+		len = snprintf(buf, size, "Cook %d is going to the counter to deliver %s – counter items %s\n",
+				e->number, course, items);
+		break;
+	case TRACE_COOK_PLACED:
+		len = snprintf(buf, size, "Cook %d placed %s on the counter - counter items %s\n",
+				e->number, course, items);
+		break;
+	case TRACE_COOK_DONE:
+		len = snprintf(buf, size, "Cook %d finished serving - items at kitchen: %d - going home - GOODBYE!!!\n", e->number, e->value);
+		break;
+	case TRACE_STUDENT_COUNTER:
+		len = snprintf(buf, size, "Student %d is going to the counter (round %d) - # of students at counter: %d and counter items %s\n",
+				e->number, e->round, e->value, items);
+		break;
+	case TRACE_STUDENT_GOT:
+		len = snprintf(buf, size, "Student %d got food and is going to get a table (round %d) - # of empty tables: %d\n",
+				e->number, e->round, e->empty);
+		break;
+	case TRACE_STUDENT_SAT:
+		len = snprintf(buf, size, "Student %d sat at table %d to eat (round %d) - empty tables: %d\n", e->number, e->value, e->round, e->empty);
+		break;
+	case TRACE_STUDENT_LEFT:
+		len = snprintf(buf, size, "Student %d left table %d to eat again (round %d) - empty tables:%d\n", e->number, e->value, e->round, e->empty);
+		break;
+	case TRACE_STUDENT_DONE:
+		len = snprintf(buf, size, "Student %d is done eating %d times - going home - GOODBYE!!!\n", e->number, e->round);
+		break;
+	default:
+		len = 0;
+		break;
+	}
+	if(len < 0)
+		return 0;
+	return ((size_t)len < size) ? len : (int)size - 1;
+}
+
+void event_set_hall(const int hall)
+{
+	event_hall = hall;
+}
+
+static void event_items(Trace_Record *e, const int *items)
+{
+	memcpy(e->items, items, menu.count * sizeof(int));
+}
+
+static void event_emit(Trace_Record *e)
+{
+	if(trace_enabled())
+		trace_write(e);
+	if(log_enabled())
+	{
+		char line[LOG_LINE_SIZE];
+		int len = 0;
+		if(event_hall >= 0)
+			len = snprintf(line, sizeof(line), "Hall %d: ", event_hall);
+		len += event_format(e, line + len, sizeof(line) - len);
+		log_write(line, len);
+	}
+}
+
+void event_supplier_going(const int course, const int *items)
+{
+	Trace_Record e = {.role = TRACE_SUPPLIER, .code = TRACE_SUPPLIER_GOING, .course = course};
+	event_items(&e, items);
+	event_emit(&e);
+}
+
+void event_supplier_delivered(const int course, const int *items)
+{
+	Trace_Record e = {.role = TRACE_SUPPLIER, .code = TRACE_SUPPLIER_DELIVERED, .course = course};
+	event_items(&e, items);
+	event_emit(&e);
+}
+
+void event_supplier_done(void)
+{
+	Trace_Record e = {.role = TRACE_SUPPLIER, .code = TRACE_SUPPLIER_DONE};
+	event_emit(&e);
+}
+
+void event_cook_kitchen(const int number, const int *items)
+{
+	Trace_Record e = {.number = number, .role = TRACE_COOK, .code = TRACE_COOK_KITCHEN};
+	event_items(&e, items);
+	event_emit(&e);
+}
+
+void event_cook_going(const int number, const int course, const int *items)
+{
+	Trace_Record e = {.number = number, .role = TRACE_COOK, .code = TRACE_COOK_GOING, .course = course};
+	event_items(&e, items);
+	event_emit(&e);
+}
+
+void event_cook_placed(const int number, const int course, const int *items)
+{
+	Trace_Record e = {.number = number, .role = TRACE_COOK, .code = TRACE_COOK_PLACED, .course = course};
+	event_items(&e, items);
+	event_emit(&e);
+}
+
+void event_cook_done(const int number, const int items)
+{
+	Trace_Record e = {.number = number, .role = TRACE_COOK, .code = TRACE_COOK_DONE, .value = items};
+	event_emit(&e);
+}
+
+void event_student_counter(const int number, const int round, const int at_counter, const int *items)
+{
+	Trace_Record e = {.number = number, .role = TRACE_STUDENT, .code = TRACE_STUDENT_COUNTER, .round = round, .value = at_counter};
+	event_items(&e, items);
+	event_emit(&e);
+}
+
+void event_student_got(const int number, const int round, const int empty_tables)
+{
+	Trace_Record e = {.number = number, .role = TRACE_STUDENT, .code = TRACE_STUDENT_GOT, .round = round, .empty = empty_tables};
+	event_emit(&e);
+}
+
+void event_student_sat(const int number, const int table, const int round, const int empty_tables)
+{
+	Trace_Record e = {.number = number, .role = TRACE_STUDENT, .code = TRACE_STUDENT_SAT, .round = round, .value = table,
+			.empty = empty_tables};
+	event_emit(&e);
+}
+
+void event_student_left(const int number, const int table, const int round, const int empty_tables)
+{
+	Trace_Record e = {.number = number, .role = TRACE_STUDENT, .code = TRACE_STUDENT_LEFT, .round = round, .value = table,
+			.empty = empty_tables};
+	event_emit(&e);
+}
+
+void event_student_done(const int number, const int rounds)
+{
+	Trace_Record e = {.number = number, .role = TRACE_STUDENT, .code = TRACE_STUDENT_DONE, .round = rounds};
+	event_emit(&e);
+}
@@ -0,0 +1,26 @@
+#ifndef PROGRAM_EVENTS_H
+#define PROGRAM_EVENTS_H
+
+/* Libraries */
+#include <stddef.h>
+#include "program-trace.h"
+/* Libraries End*/
+
+/* Function Definitions */
+int event_format(const Trace_Record*, char*, const size_t);
+void event_set_hall(const int);
+void event_supplier_going(const int, const int*);
+void event_supplier_delivered(const int, const int*);
+void event_supplier_done(void);
+void event_cook_kitchen(const int, const int*);
+void event_cook_going(const int, const int, const int*);
+void event_cook_placed(const int, const int, const int*);
+void event_cook_done(const int, const int);
+void event_student_counter(const int, const int, const int, const int*);
+void event_student_got(const int, const int, const int);
+void event_student_sat(const int, const int, const int, const int);
+void event_student_left(const int, const int, const int, const int);
+void event_student_done(const int, const int);
+/* Function Definitions End*/
+
+#endif
@@ -0,0 +1,334 @@
+/* Libraries */
+#define _GNU_SOURCE
+#include "program-input.h"
+#include "program-utils.h"
+#include "program-menu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+/* Libraries End*/
+
+/*
+ * Plate source of the supplier. A regular file is mapped once and handed out
+ * from memory; anything that cannot be mapped (stdin, pipes, sockets) is read
+ * in INPUT_BLK_SIZE blocks. Either way the supplier loop does not issue a
+ * system call per plate. Blanks between plates are skipped, so generators may
+ * write one plate per line.
+ *
+ * The actor engine reads through a Plate_Stream: a prefetch thread reads and
+ * decodes the input into a ring of INPUT_QUEUE_BLOCKS course blocks, and the
+ * supplier only takes courses out of it. A block is handed over as soon as
+ * one read() has been decoded, so a slow generator is not held back until a
+ * whole block fills.
+ *
+ * Under --halls every hall reads its own slice of the input, a range of the
+ * plates of each course: hall h takes plates h * L * M to (h + 1) * L * M - 1
+ * of every course and passes over the others. A slice by position would give
+ * a hall of a shuffled input more of one course than of another, and trays it
+ * can never complete. Input that cannot be mapped is first spooled into a
+ * memfd by the parent, so every hall can open and map it.
+ */
+
+static int is_blank(const char c)
+{
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+int input_open(Plate_Input *input, const char *path)
+{
+	input->data = NULL;
+	input->size = 0;
+	input->pos = 0;
+	input->is_mapped = FALSE;
+	input_slice(input, 0, LLONG_MAX);
+
+	if(strcmp(path, INPUT_STDIN) == 0)
+		input->fd = STDIN_FILENO;
+	else if((input->fd = open(path, O_RDONLY)) == -1)
+		return FALSE;
+
+	struct stat st;
+	if(fstat(input->fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+	{
+		void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, input->fd, 0);
+		if(map != MAP_FAILED)
+		{
+			madvise(map, st.st_size, MADV_SEQUENTIAL);
+			input->data = map;
+			input->size = st.st_size;
+			input->is_mapped = TRUE;
+			return TRUE;
+		}
+	}
+
+	posix_fadvise(input->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	input->data = malloc(INPUT_BLK_SIZE);
+	if(input->data == NULL)
+		return FALSE;
+	return TRUE;
+}
+
+/* reads the next block once the current one is used up, FALSE at the end of the input */
+static int input_fill(Plate_Input *input)
+{
+	if(input->is_mapped)
+		return FALSE;
+
+	ssize_t read_byte;
+	while((read_byte = read(input->fd, input->data, INPUT_BLK_SIZE)) == -1 && errno == EINTR);
+	if(read_byte == -1)
+	{
+		char *err_msg = "read(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	if(read_byte == 0)
+		return FALSE;
+	input->size = read_byte;
+	input->pos = 0;
+	return TRUE;
+}
+
+/* whether a plate of course is in the slice of this reader, counts it either way */
+static int input_take(Plate_Input *input, const int course)
+{
+	long long seen = input->seen[course]++;
+	return seen >= input->first && seen < input->last;
+}
+
+int input_next(Plate_Input *input, int *course)
+{
+	char plate_type;
+	do
+	{
+		do
+		{
+			if(input->pos == input->size && !input_fill(input))
+				return PLATE_END;
+			plate_type = input->data[input->pos++];
+		} while(is_blank(plate_type));
+
+		*course = course_of(plate_type);
+		if(*course == -1)
+			return PLATE_INVALID;
+	} while(!input_take(input, *course));
+	return PLATE_OK;
+}
+
+void input_slice(Plate_Input *input, const long long first, const long long count)
+{
+	input->first = first;
+	input->last = (count > LLONG_MAX - first) ? LLONG_MAX : first + count;
+	for(int course = 0; course < MENU_MAX; course++)
+		input->seen[course] = 0;
+}
+
+void input_close(Plate_Input *input)
+{
+	if(input->is_mapped)
+		munmap(input->data, input->size);
+	else
+		free(input->data);
+	if(input->fd != STDIN_FILENO)
+		close(input->fd);
+}
+
+const char *input_spool(const char *path, const long long plates)
+{
+	/* plates is the number of each course needed, the spool ends once every course has them */
+	static char spool_path[64];
+	Plate_Input input;
+	if(!input_open(&input, path))
+		return NULL;
+	if(input.is_mapped)
+	{
+		input_close(&input);
+		return path;
+	}
+
+	int fd = memfd_create("messhall-input", 0);
+	if(fd == -1)
+	{
+		input_close(&input);
+		return NULL;
+	}
+	long long seen[MENU_MAX] = {0};
+	int short_courses = menu.count;			//courses with fewer plates than needed so far
+	while(short_courses > 0 && (input.pos < input.size || input_fill(&input)))
+	{
+		size_t start = input.pos;
+		while(input.pos < input.size && short_courses > 0)
+		{
+			char plate_type = input.data[input.pos++];
+			int course = course_of(plate_type);
+			if(course != -1 && ++seen[course] == plates)
+				short_courses--;
+			/* the halls stop reading at a character that is no plate */
+			else if(course == -1 && !is_blank(plate_type))
+				short_courses = 0;
+		}
+		for(size_t done = start; done < input.pos; )
+		{
+			ssize_t written = write(fd, input.data + done, input.pos - done);
+			if(written == -1 && errno != EINTR)
+			{
+				char *err_msg = "write(): unsuccessful!\n";
+				write(STDERR_FILENO, err_msg, strlen(err_msg));
+				exit(EXIT_FAILURE);
+			}
+			if(written > 0)
+				done += written;
+		}
+	}
+	input_close(&input);
+
+	/* forked halls inherit the descriptor and open the same memory through it */
+	snprintf(spool_path, sizeof(spool_path), "/proc/self/fd/%d", fd);
+	return spool_path;
+}
+
+/* courses of the first plates of a file, without reading a stream that cannot be read twice */
+int input_count(const char *path, const long long plates, long long *counts)
+{
+	for(int course = 0; course < MENU_MAX; course++)
+		counts[course] = 0;
+	/* opening a FIFO would block until it has a writer */
+	struct stat st;
+	if(strcmp(path, INPUT_STDIN) == 0 || stat(path, &st) == -1)
+		return PLATE_END;
+	Plate_Input input;
+	if(!S_ISREG(st.st_mode))
+		return PLATE_UNCOUNTED;
+	if(!input_open(&input, path))
+		return PLATE_END;
+	if(!input.is_mapped)
+	{
+		input_close(&input);
+		return PLATE_UNCOUNTED;
+	}
+	int status = PLATE_OK;
+	int course;
+	for(long long i = 0; i < plates && (status = input_next(&input, &course)) == PLATE_OK; i++)
+		counts[course]++;
+	input_close(&input);
+	return status;
+}
+
+/* decodes what one read() returned into block, the status says how the input goes on */
+static void stream_decode(Plate_Input *input, Plate_Block *block)
+{
+	block->count = 0;
+	block->status = PLATE_OK;
+	while(block->count == 0)
+	{
+		if(input->pos == input->size && !input_fill(input))
+		{
+			block->status = PLATE_END;
+			return;
+		}
+		while(input->pos < input->size && block->count < INPUT_BLK_SIZE)
+		{
+			char plate_type = input->data[input->pos++];
+			if(is_blank(plate_type))
+				continue;
+			int course = course_of(plate_type);
+			if(course == -1)
+			{
+				block->status = PLATE_INVALID;
+				return;
+			}
+			if(input_take(input, course))
+				block->course[block->count++] = course;
+		}
+	}
+}
+
+static void *stream_prefetch(void *arg)
+{
+	Plate_Stream *stream = arg;
+	int tail = 0;
+	int status = PLATE_OK;
+	while(status == PLATE_OK)
+	{
+		sync_wait(&stream->free_sem);
+		if(atomic_load(&stream->is_stopped))
+			break;
+		stream_decode(&stream->input, &stream->blocks[tail]);
+		status = stream->blocks[tail].status;
+		sync_post(&stream->full_sem);
+		tail = (tail + 1) % INPUT_QUEUE_BLOCKS;
+	}
+	return NULL;
+}
+
+Plate_Stream *stream_open(const char *path, const long long first, const long long count)
+{
+	Plate_Stream *stream = malloc(sizeof(Plate_Stream));
+	if(stream == NULL)
+		return NULL;
+	if(!input_open(&stream->input, path))
+	{
+		free(stream);
+		return NULL;
+	}
+	input_slice(&stream->input, first, count);
+	atomic_init(&stream->is_stopped, FALSE);
+	stream->head = 0;
+	stream->is_held = FALSE;
+	stream->pos = 0;
+	if(sync_init(&stream->free_sem, 0, INPUT_QUEUE_BLOCKS) == -1 || sync_init(&stream->full_sem, 0, 0) == -1)
+	{
+		char *err_msg = "sync_init(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	if(pthread_create(&stream->thread, NULL, stream_prefetch, stream) != 0)
+	{
+		char *err_msg = "pthread_create(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	return stream;
+}
+
+int stream_next(Plate_Stream *stream, int *course)
+{
+	while(TRUE)
+	{
+		if(!stream->is_held)
+		{
+			sync_wait(&stream->full_sem);
+			stream->is_held = TRUE;
+			stream->pos = 0;
+		}
+		Plate_Block *block = &stream->blocks[stream->head];
+		if(stream->pos < block->count)
+		{
+			*course = block->course[stream->pos++];
+			return PLATE_OK;
+		}
+		/* the last block stays held, later calls see the same end */
+		if(block->status != PLATE_OK)
+			return block->status;
+		stream->is_held = FALSE;
+		stream->head = (stream->head + 1) % INPUT_QUEUE_BLOCKS;
+		sync_post(&stream->free_sem);
+	}
+}
+
+void stream_close(Plate_Stream *stream)
+{
+	/* the prefetch thread either waits for a free block or sits in read() on a generator that does not end */
+	atomic_store(&stream->is_stopped, TRUE);
+	sync_post(&stream->free_sem);
+	pthread_cancel(stream->thread);
+	pthread_join(stream->thread, NULL);
+	input_close(&stream->input);
+	free(stream);
+}
@@ -0,0 +1,77 @@
+#ifndef PROGRAM_INPUT_H
+#define PROGRAM_INPUT_H
+
+/* Libraries */
+#include <stddef.h>
+#include <pthread.h>
+#include "program-sync.h"
+#include "program-menu.h"
+/* Libraries End*/
+
+/* Macro Constants */
+#define INPUT_BLK_SIZE 65536
+#define INPUT_STDIN "-"
+#define INPUT_QUEUE_BLOCKS 4				//decoded blocks between the prefetch thread and the supplier
+/* Macro Constants End */
+
+/* Enums */
+enum Plate_Status
+{
+	PLATE_END = 0,							//no plate left in the input
+	PLATE_OK = 1,							//a plate was handed out
+	PLATE_INVALID = -1,						//the input holds a character that is no plate
+	PLATE_UNCOUNTED = -2					//the input is a stream, counting it would consume it
+};
+/* Enums End */
+
+/* Structs */
+struct Plate_Input
+{
+	int fd;							//descriptor of the input
+	char *data;						//mapped file or read block
+	size_t size;					//number of valid bytes at data
+	size_t pos;						//next byte to hand out
+	int is_mapped;					//whether data is an mmap of the whole file
+	long long first;				//plates of each course left to the halls before this one
+	long long last;					//end of the plates of each course this reader takes
+	long long seen[MENU_MAX];		//plates of each course read so far
+};
+struct Plate_Block
+{
+	size_t count;					//decoded plates in course
+	int status;						//PLATE_OK, or how the input ends after these plates
+	unsigned char course[INPUT_BLK_SIZE];	//courses of the plates, see course_of()
+};
+struct Plate_Stream
+{
+	struct Plate_Input input;		//read by the prefetch thread only
+	pthread_t thread;				//prefetch thread
+	atomic_int is_stopped;			//set by the supplier when it needs no more plates
+	Sync_Sem free_sem;				//blocks the prefetch thread may fill
+	Sync_Sem full_sem;				//blocks the supplier may take
+	int head;						//block the supplier takes plates from
+	int is_held;					//whether the supplier holds the head block
+	size_t pos;						//next plate of the head block
+	struct Plate_Block blocks[INPUT_QUEUE_BLOCKS];
+};
+/* Structs End */
+
+/* Typdefs */
+typedef struct Plate_Input Plate_Input;
+typedef struct Plate_Block Plate_Block;
+typedef struct Plate_Stream Plate_Stream;
+/* Typedefs End*/
+
+/* Function Definitions */
+int input_open(Plate_Input*, const char*);
+int input_next(Plate_Input*, int*);
+void input_slice(Plate_Input*, const long long, const long long);
+void input_close(Plate_Input*);
+const char *input_spool(const char*, const long long);
+int input_count(const char*, const long long, long long*);
+Plate_Stream *stream_open(const char*, const long long, const long long);
+int stream_next(Plate_Stream*, int*);
+void stream_close(Plate_Stream*);
+/* Function Definitions End*/
+
+#endif
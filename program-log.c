@@ -0,0 +1,187 @@
+/* Libraries */
+#include "program-log.h"
+#include "program-uring.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+/* Libraries End*/
+
+/*
+ * Event output of the actors. In buffered mode each process formats into its
+ * own buffer and the buffer is written with a single write() once it cannot
+ * hold another line, or when the process exits. Buffers are thread local, an
+ * actor thread flushes its own buffer before it returns. Holding a semaphore while
+ * logging then costs formatting a line, not a system call.
+ *
+ * With the uring backend a full buffer is handed to io_uring and the actor
+ * goes on filling a second one; the next hand-off first reaps the previous
+ * write, so a process keeps its own order with one write in flight. Without
+ * io_uring, or when a write fails, the output falls back to write(). The ring
+ * writes stdout only. Writes of different processes to a regular file would
+ * all start at the shared file position they read, and could overwrite each
+ * other, so such a stdout is switched to O_APPEND first.
+ */
+
+/* Global Variables */
+static int log_mode = LOG_SYNC;			//current output mode
+static int log_backend = LOG_BACKEND_WRITE;	//how buffered output is written
+static __thread char log_space[LOG_BUF_SIZE];	//output buffer of this process or thread
+static __thread char *log_buf = NULL;		//buffer being filled, log_space or log_spare
+static __thread size_t log_len = 0;			//number of pending bytes
+static __thread Uring log_ring = {.fd = -1};	//ring of this process or thread
+static __thread int ring_state = 0;			//0 not set up, 1 ready, -1 unavailable
+static __thread char *log_spare = NULL;		//second buffer, filled while the other one is written
+static __thread const char *flight_buf = NULL;	//buffer the ring is writing
+static __thread size_t flight_len = 0;
+/* Global Variables End */
+
+static void write_all(const char *buf, size_t len)
+{
+	while(len > 0)
+	{
+		ssize_t written = write(STDOUT_FILENO, buf, len);
+		if(written == -1)
+		{
+			if(errno == EINTR)
+				continue;
+			char *err_msg = "write(): unsuccessful!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
+			exit(EXIT_FAILURE);
+		}
+		buf += written;
+		len -= written;
+	}
+}
+
+static int ring_ready(void)
+{
+	if(ring_state == 0)
+	{
+		log_spare = malloc(LOG_BUF_SIZE);
+		ring_state = (log_spare != NULL && uring_open(&log_ring) == 0) ? 1 : -1;
+		if(ring_state == -1)
+		{
+			free(log_spare);
+			log_spare = NULL;
+		}
+	}
+	return ring_state == 1;
+}
+
+static void ring_complete(void)
+{
+	if(flight_buf == NULL)
+		return;
+	int res = uring_wait(&log_ring);
+	if(res < 0)
+	{
+		/* e.g. a kernel without IORING_OP_WRITE, write() from now on */
+		write_all(flight_buf, flight_len);
+		uring_close(&log_ring);
+		ring_state = -1;
+	}
+	else if((size_t)res < flight_len)
+		write_all(flight_buf + res, flight_len - res);
+	flight_buf = NULL;
+}
+
+static void log_submit(void)
+{
+	if(log_len == 0)
+		return;
+	if(log_backend == LOG_BACKEND_URING && ring_ready())
+	{
+		ring_complete();
+		if(ring_state == 1 && uring_write(&log_ring, STDOUT_FILENO, log_buf, log_len) == 0)
+		{
+			flight_buf = log_buf;
+			flight_len = log_len;
+			log_buf = (log_buf == log_space) ? log_spare : log_space;
+			log_len = 0;
+			return;
+		}
+	}
+	write_all(log_buf, log_len);
+	log_len = 0;
+}
+
+int log_parse_mode(const char *name)
+{
+	if(strcmp(name, "off") == 0)
+		return LOG_OFF;
+	if(strcmp(name, "buffered") == 0)
+		return LOG_BUFFERED;
+	if(strcmp(name, "sync") == 0)
+		return LOG_SYNC;
+	return -1;
+}
+
+int log_parse_backend(const char *name)
+{
+	if(strcmp(name, "write") == 0)
+		return LOG_BACKEND_WRITE;
+	if(strcmp(name, "uring") == 0)
+		return LOG_BACKEND_URING;
+	return -1;
+}
+
+void log_init(const int mode, const int backend)
+{
+	log_mode = mode;
+	log_backend = backend;
+	log_len = 0;
+	if(mode == LOG_BUFFERED)
+		atexit(log_flush);
+
+	/* set once before the fork, the actors share the open file of stdout */
+	struct stat st;
+	int flags;
+	if(mode == LOG_BUFFERED && backend == LOG_BACKEND_URING && fstat(STDOUT_FILENO, &st) == 0 &&
+	   S_ISREG(st.st_mode) && (flags = fcntl(STDOUT_FILENO, F_GETFL)) != -1 && !(flags & O_APPEND))
+		fcntl(STDOUT_FILENO, F_SETFL, flags | O_APPEND);
+}
+
+int log_enabled(void)
+{
+	return log_mode != LOG_OFF;
+}
+
+void log_write(const char *line, const int len)
+{
+	if(log_mode == LOG_OFF || len <= 0)
+		return;
+
+	if(log_mode == LOG_SYNC)
+		write_all(line, (size_t)len);
+	else
+	{
+		if(log_buf == NULL)
+			log_buf = log_space;
+		if(LOG_BUF_SIZE - log_len < (size_t)len)
+			log_submit();
+		memcpy(log_buf + log_len, line, (size_t)len);
+		log_len += (size_t)len;
+	}
+}
+
+void log_flush(void)
+{
+	/* a ring is only worth setting up for an actor that filled a buffer before */
+	if(ring_state != 1)
+	{
+		if(log_len > 0)
+			write_all(log_buf, log_len);
+		log_len = 0;
+		return;
+	}
+	log_submit();
+	ring_complete();
+	uring_close(&log_ring);
+	log_buf = log_space;
+	free(log_spare);
+	log_spare = NULL;
+	ring_state = 0;
+}
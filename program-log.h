@@ -0,0 +1,32 @@
+#ifndef PROGRAM_LOG_H
+#define PROGRAM_LOG_H
+
+/* Macro Constants */
+#define LOG_BUF_SIZE 65536
+#define LOG_LINE_SIZE 512
+/* Macro Constants End */
+
+/* Enums */
+enum Log_Mode
+{
+	LOG_OFF,						//no event output at all
+	LOG_BUFFERED,					//events are coalesced in a per-process buffer
+	LOG_SYNC						//every event is written immediately, in order
+};
+enum Log_Backend
+{
+	LOG_BACKEND_WRITE,				//buffers are written with write()
+	LOG_BACKEND_URING				//buffers are submitted to io_uring, one in flight per process
+};
+/* Enums End */
+
+/* Function Definitions */
+int log_parse_mode(const char*);
+int log_parse_backend(const char*);
+void log_init(const int, const int);
+int log_enabled(void);
+void log_write(const char*, const int);
+void log_flush(void);
+/* Function Definitions End*/
+
+#endif
@@ -0,0 +1,136 @@
+/* Libraries */
+#include "program-menu.h"
+#include "program-utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+/* Libraries End*/
+
+/*
+ * Courses of the mess hall. A menu is a list of courses, each a plate code of
+ * the input and a name for the events: "CODE:name,..." or just the codes, as
+ * in "PCDF" or "P,C,D,F", where the soup, main course and desert of the
+ * default keep their names. A tray holds one plate of every course; the k-th
+ * plate claimed of course c is numbered k * count + c, so it goes on tray k.
+ * Counters and semaphores of the kitchen and the counter are arrays over the
+ * courses, input bytes map to courses through one table lookup.
+ */
+
+/* Global Variables */
+Menu menu;
+static const char *default_names[] = {"P", "soup", "C", "main course", "D", "desert", NULL};
+/* Global Variables End */
+
+static int menu_add(const char code, const char *name, const size_t name_len)
+{
+	/* separators of the spec and JSON quoting cannot be codes */
+	if(menu.count == MENU_MAX || !isgraph((unsigned char)code) || strchr(",:\"\\", code) != NULL ||
+	   menu.course[(unsigned char)code] != -1 || name_len == 0 || name_len >= MENU_NAME_SIZE)
+		return -1;
+	menu.code[menu.count] = code;
+	memcpy(menu.name[menu.count], name, name_len);
+	menu.name[menu.count][name_len] = '\0';
+	menu.course[(unsigned char)code] = menu.count;
+	menu.count++;
+	return 0;
+}
+
+static int menu_add_code(const char code)
+{
+	/* a known code keeps its name and any other is named after itself */
+	char name[MENU_NAME_SIZE];
+	snprintf(name, sizeof(name), "course %c", code);
+	for(int i = 0; default_names[i] != NULL; i += 2)
+		if(default_names[i][0] == code)
+			snprintf(name, sizeof(name), "%s", default_names[i + 1]);
+	return menu_add(code, name, strlen(name));
+}
+
+int menu_parse(const char *spec)
+{
+	if(strlen(spec) >= MENU_SPEC_SIZE)
+		return -1;
+	Menu previous = menu;
+	menu.count = 0;
+	memset(menu.course, -1, sizeof(menu.course));
+	int is_valid = TRUE;
+	if(strchr(spec, ',') == NULL && strchr(spec, ':') == NULL)
+	{
+		for(const char *c = spec; *c != '\0' && is_valid; c++)
+			is_valid = (menu_add_code(*c) == 0);
+	}
+	else
+	{
+		for(const char *item = spec; is_valid; item++)
+		{
+			const char *end = strchr(item, ',');
+			if(end == NULL)
+				end = item + strlen(item);
+			if(end - item == 1)
+				is_valid = (menu_add_code(item[0]) == 0);
+			else
+				is_valid = (end - item >= 3 && item[1] == ':' && menu_add(item[0], item + 2, end - item - 2) == 0);
+			if(*end == '\0')
+				break;
+			item = end;
+		}
+	}
+	if(!is_valid || menu.count == 0)
+	{
+		menu = previous;
+		return -1;
+	}
+	snprintf(menu.spec, sizeof(menu.spec), "%s", spec);
+	return 0;
+}
+
+int menu_load(const char *dir)
+{
+	char path[4096];
+	char spec[MENU_SPEC_SIZE];
+	snprintf(path, sizeof(path), MENU_FILE, dir);
+	FILE *file = fopen(path, "r");
+	if(file == NULL)
+		return -1;
+	int is_read = (fgets(spec, sizeof(spec), file) != NULL);
+	fclose(file);
+	if(!is_read)
+		return -1;
+	spec[strcspn(spec, "\n")] = '\0';
+	return menu_parse(spec);
+}
+
+void menu_save(const char *dir)
+{
+	char path[4096];
+	snprintf(path, sizeof(path), MENU_FILE, dir);
+	FILE *file = fopen(path, "w");
+	if(file == NULL || fprintf(file, "%s\n", menu.spec) < 0 || fclose(file) != 0)
+	{
+		char *err_msg = "menu_save(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+}
+
+int course_of(const char plate_type)
+{
+	return menu.course[(unsigned char)plate_type];
+}
+
+int menu_items(const int *items, char *buf, const size_t size)
+{
+	/* "P:1,C:0,D:2=3" for the default menu */
+	int len = 0;
+	int sum = 0;
+	for(int course = 0; course < menu.count && (size_t)len < size; course++)
+	{
+		len += snprintf(buf + len, size - len, (course == 0) ? "%c:%d" : ",%c:%d", menu.code[course], items[course]);
+		sum += items[course];
+	}
+	if((size_t)len < size)
+		len += snprintf(buf + len, size - len, "=%d", sum);
+	return ((size_t)len < size) ? len : (int)size - 1;
+}
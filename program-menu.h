@@ -0,0 +1,55 @@
+#ifndef PROGRAM_MENU_H
+#define PROGRAM_MENU_H
+
+/* Libraries */
+#include <stddef.h>
+/* Libraries End*/
+
+/* Macro Constants */
+#define MENU_DEFAULT "P:soup,C:main course,D:desert"
+#define MENU_MAX 8							//courses a menu can have
+#define MENU_FAST 3							//course count of the specialised fast path
+#define MENU_NAME_SIZE 32
+#define MENU_SPEC_SIZE (MENU_MAX * (MENU_NAME_SIZE + 3))
+#define MENU_FILE "%s/menu"					//menu of a trace, next to its trace files
+/* Macro Constants End */
+
+/*
+ * Hot loops over the courses are written once as MENU_INLINE functions that
+ * take the course count as their first argument. MENU_SPECIALIZE calls one
+ * with the constant MENU_FAST for the 3-course menu, so that copy has its
+ * loops unrolled and its divisions by the course count turned into
+ * multiplications, and with the runtime count for any other menu.
+ */
+#define MENU_INLINE static inline __attribute__((always_inline))
+#define MENU_SPECIALIZE(fn, ...) \
+	((menu.count == MENU_FAST) ? fn(MENU_FAST, ##__VA_ARGS__) : fn(menu.count, ##__VA_ARGS__))
+
+/* Structs */
+struct Menu
+{
+	int count;								//courses of the menu, one plate of each makes a tray
+	char code[MENU_MAX];					//plate code of each course in the input
+	char name[MENU_MAX][MENU_NAME_SIZE];	//name of each course in the events
+	signed char course[256];				//course of every input byte, -1 if it is not a plate code
+	char spec[MENU_SPEC_SIZE];				//the menu as given, saved next to a trace
+};
+/* Structs End */
+
+/* Typdefs */
+typedef struct Menu Menu;
+/* Typedefs End*/
+
+/* Global Variables */
+extern Menu menu;
+/* Global Variables End */
+
+/* Function Definitions */
+int menu_parse(const char*);
+int menu_load(const char*);
+void menu_save(const char*);
+int course_of(const char);
+int menu_items(const int*, char*, const size_t);
+/* Function Definitions End*/
+
+#endif
@@ -0,0 +1,212 @@
+/* Libraries */
+#include "program-metrics.h"
+#include "program-menu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+/* Libraries End*/
+
+/*
+ * Live metrics of a run, for ./messhall-top. With --metrics the parent
+ * creates the named segment METRICS_SEG-<pid> in every mode, so a monitor can
+ * attach while threads run in private memory too, and runs or halls side by
+ * side each have their own.
+ *
+ * Actors only write their own Metrics_Actor slot, with relaxed stores.
+ * Totals and gauges are not kept twice: a sampler thread of the parent reads
+ * Run_Stats, the tables and the gauges of the kitchen and the counter every
+ * METRICS_PERIOD_NS, and publishes them as one Metrics_Sample under a
+ * sequence lock; messhall-top.c holds the reading side. A monitor maps the
+ * segment read-only, so it never writes a line the run uses.
+ */
+
+/* Global Variables */
+static Hall_Metrics *metrics;				//NULL unless --metrics
+static int metrics_fd = -1;
+static char metrics_name[METRICS_NAME_SIZE];
+static pid_t metrics_owner;					//process that created the segment and removes it
+static size_t metrics_bytes;
+static Table_Set *metrics_tables;
+static Metrics_Gauge metrics_gauge;
+static pthread_t sampler;
+static int is_sampling;
+static atomic_int is_stopped;
+static Sync_Sem stop_sem;					//wakes the sampler early when the run ends
+static __thread Metrics_Actor *local_slot;	//slot of this actor
+/* Global Variables End */
+
+static void metrics_unlink(void)
+{
+	if(metrics_fd != -1)
+		shm_unlink(metrics_name);
+	metrics_fd = -1;
+}
+
+/* an actor that exits the process or a SIGINT must not leave the segment behind, forked actors leave it alone */
+static void metrics_exit(void)
+{
+	if(getpid() == metrics_owner)
+		metrics_unlink();
+}
+
+size_t metrics_size(const int actors)
+{
+	return sizeof(Hall_Metrics) + (size_t)actors * sizeof(Metrics_Actor);
+}
+
+void metrics_open(const int hall, const int mode, const int N, const int M, const int T, const int S, const int L,
+		const int K, const int actors)
+{
+	metrics_bytes = metrics_size(actors);
+	metrics_owner = getpid();
+	snprintf(metrics_name, sizeof(metrics_name), METRICS_SEG "-%d", (int)metrics_owner);
+	/* a segment left by a dead process with the same pid is stale */
+	shm_unlink(metrics_name);
+	metrics_fd = shm_open(metrics_name, O_CREAT | O_EXCL | O_RDWR, 0644);
+	if(metrics_fd < 0)
+	{
+		char *err_msg = "shm_open(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	atexit(metrics_exit);
+	if(ftruncate(metrics_fd, metrics_bytes) == -1)
+	{
+		char *err_msg = "ftruncate(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	metrics = mmap(NULL, metrics_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, metrics_fd, 0);
+	if(metrics == MAP_FAILED)
+	{
+		char *err_msg = "mmap(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+
+	memset(metrics, 0, metrics_bytes);
+	metrics->pid = metrics_owner;
+	metrics->hall = hall;
+	metrics->mode = mode;
+	metrics->N = N;
+	metrics->M = M;
+	metrics->T = T;
+	metrics->S = S;
+	metrics->L = L;
+	metrics->K = K;
+	metrics->actors = actors;
+	for(int i = 0; i < actors; i++)
+		metrics->actor[i].role = (i == 0) ? ROLE_SUPPLIER : (i <= N) ? ROLE_COOK : ROLE_STUDENT;
+	atomic_store(&metrics->state, METRICS_STARTING);
+	atomic_thread_fence(memory_order_release);
+	metrics->magic = METRICS_MAGIC;
+}
+
+static void metrics_sample(void)
+{
+	Metrics_Sample sample;
+	long long start_ns = run_stats->start_ns;
+	sample.time_ns = (start_ns == 0) ? 0 : stats_now() - start_ns;
+	sample.plates_delivered = atomic_load_explicit(&run_stats->plates_delivered, memory_order_relaxed);
+	sample.plates_served = atomic_load_explicit(&run_stats->plates_served, memory_order_relaxed);
+	sample.trays_taken = atomic_load_explicit(&run_stats->trays_taken, memory_order_relaxed);
+	sample.meals = atomic_load_explicit(&run_stats->meals, memory_order_relaxed);
+	metrics_gauge(&sample.kitchen_plates, &sample.at_counter);
+	/* a tray taken by a student removes one plate of each course */
+	sample.counter_plates = sample.plates_served - menu.count * sample.trays_taken;
+	sample.tables_busy = metrics_tables->count - tables_empty(metrics_tables);
+	sample.actors_done = atomic_load_explicit(&metrics->actors_done, memory_order_relaxed);
+	for(int role = 0; role < ROLE_COUNT; role++)
+		sample.wait_ns[role] = atomic_load_explicit(&run_stats->wait_ns[role].value, memory_order_relaxed);
+
+	unsigned int seq = atomic_load_explicit(&metrics->seq, memory_order_relaxed);
+	atomic_store_explicit(&metrics->seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	metrics->sample = sample;
+	atomic_store_explicit(&metrics->seq, seq + 2, memory_order_release);
+
+	if(start_ns != 0 && atomic_load(&metrics->state) == METRICS_STARTING)
+		atomic_store(&metrics->state, METRICS_RUNNING);
+}
+
+static void *metrics_sampler(void *arg)
+{
+	(void)arg;
+	while(!atomic_load(&is_stopped))
+	{
+		metrics_sample();
+		sync_timedwait(&stop_sem, METRICS_PERIOD_NS);
+	}
+	return NULL;
+}
+
+void metrics_start(Table_Set *tables, Metrics_Gauge gauge)
+{
+	if(metrics == NULL)
+		return;
+	metrics_tables = tables;
+	metrics_gauge = gauge;
+	atomic_init(&is_stopped, FALSE);
+	if(sync_init(&stop_sem, 0, 0) == -1 || pthread_create(&sampler, NULL, metrics_sampler, NULL) != 0)
+	{
+		char *err_msg = "metrics_start(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	is_sampling = TRUE;
+}
+
+void metrics_actor(const int i)
+{
+	if(metrics == NULL)
+		return;
+	local_slot = &metrics->actor[i];
+	atomic_store_explicit(&local_slot->state, METRICS_RUNNING, memory_order_relaxed);
+}
+
+void metrics_progress(const long long count)
+{
+	if(local_slot != NULL)
+		atomic_store_explicit(&local_slot->progress,
+				atomic_load_explicit(&local_slot->progress, memory_order_relaxed) + count, memory_order_relaxed);
+}
+
+void metrics_wait(const long long waited)
+{
+	if(local_slot != NULL)
+		atomic_store_explicit(&local_slot->wait_ns,
+				atomic_load_explicit(&local_slot->wait_ns, memory_order_relaxed) + waited, memory_order_relaxed);
+}
+
+void metrics_actor_end(void)
+{
+	if(local_slot == NULL)
+		return;
+	atomic_store_explicit(&local_slot->state, METRICS_DONE, memory_order_relaxed);
+	atomic_fetch_add_explicit(&metrics->actors_done, 1, memory_order_relaxed);
+	local_slot = NULL;
+}
+
+void metrics_close(void)
+{
+	if(metrics == NULL)
+		return;
+	if(is_sampling)
+	{
+		atomic_store(&is_stopped, TRUE);
+		sync_post(&stop_sem);
+		pthread_join(sampler, NULL);
+		metrics_sample();
+	}
+	atomic_store(&metrics->state, METRICS_DONE);
+
+	/* a monitor still attached keeps its mapping and sees the final sample */
+	munmap(metrics, metrics_bytes);
+	close(metrics_fd);
+	metrics_unlink();
+	metrics = NULL;
+}
@@ -0,0 +1,87 @@
+#ifndef PROGRAM_METRICS_H
+#define PROGRAM_METRICS_H
+
+/* Libraries */
+#include <stdatomic.h>
+#include <sys/types.h>
+#include "program-utils.h"
+#include "program-stats.h"
+#include "program-tables.h"
+/* Libraries End*/
+
+/* Macro Constants */
+#define METRICS_SEG "/messhall-metrics"		//followed by -<pid> of the hall process
+#define METRICS_NAME_SIZE 64
+#define METRICS_MAGIC 0x4d484d32u			//"MHM2", layout of Hall_Metrics
+#define METRICS_PERIOD_NS 100000000LL		//the sampler refreshes the sample this often
+/* Macro Constants End */
+
+/* Enums */
+enum Metrics_State
+{
+	METRICS_STARTING,						//actors are being spawned
+	METRICS_RUNNING,						//actors passed the start barrier
+	METRICS_DONE							//every actor finished, the sample is final
+};
+/* Enums End */
+
+/* Structs */
+struct Metrics_Sample
+{
+	long long time_ns;						//since the actors started, 0 while they start
+	long long plates_delivered;				//plates put into the kitchen by the supplier
+	long long plates_served;				//plates put on the counter by cooks
+	long long trays_taken;					//trays taken from the counter by students
+	long long meals;						//meals eaten at tables
+	long long kitchen_plates;				//plates in the kitchen
+	long long counter_plates;				//plates on the counter
+	long long at_counter;					//students at the counter
+	long long tables_busy;					//tables taken
+	long long actors_done;					//actors that went home
+	long long wait_ns[ROLE_COUNT];			//time actors of each role spent blocked
+};
+/* Structs End */
+
+/* Shared Memory Structs*/
+struct Metrics_Actor
+{
+	atomic_llong progress;					//plates of the supplier, plates served by a cook, meals of a student
+	atomic_llong wait_ns;					//time this actor spent blocked
+	atomic_int state;						//Metrics_State of this actor
+	int role;								//Role of this actor
+};
+struct Hall_Metrics
+{
+	unsigned int magic;						//METRICS_MAGIC once the header is written
+	pid_t pid;								//process running the mess hall
+	int hall;								//hall of the process under --halls, 0 otherwise
+	int mode;								//MODE_PROCESSES or MODE_THREADS
+	int N, M, T, S, L, K;					//parameters of the run
+	int actors;								//number of actor slots
+	atomic_int state;						//Metrics_State of the run
+	CACHE_ALIGNED atomic_uint seq;			//odd while the sampler writes sample
+	struct Metrics_Sample sample;			//copied out while seq is even and unchanged
+	CACHE_ALIGNED atomic_llong actors_done;	//bumped by every actor when it finishes
+	CACHE_ALIGNED struct Metrics_Actor actor[];	//one slot per actor, written by that actor only
+};
+/* Shared Memory Structs End */
+
+/* Typdefs */
+typedef struct Metrics_Sample Metrics_Sample;
+typedef struct Metrics_Actor Metrics_Actor;
+typedef struct Hall_Metrics Hall_Metrics;
+typedef void (*Metrics_Gauge)(long long*, long long*);	//plates in the kitchen, students at the counter
+/* Typedefs End*/
+
+/* Function Definitions */
+size_t metrics_size(const int);
+void metrics_open(const int, const int, const int, const int, const int, const int, const int, const int, const int);
+void metrics_start(Table_Set*, Metrics_Gauge);
+void metrics_actor(const int);
+void metrics_progress(const long long);
+void metrics_wait(const long long);
+void metrics_actor_end(void);
+void metrics_close(void);
+/* Function Definitions End*/
+
+#endif
@@ -0,0 +1,226 @@
+/* Libraries */
+#define _GNU_SOURCE
+#include "program-pin.h"
+#include "program-stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/syscall.h>
+/* Libraries End*/
+
+/*
+ * Placement of the actors on CPUs and of the shared segments on NUMA nodes.
+ * The topology is read once in the parent from sched_getaffinity() and the
+ * node cpulists in sysfs, so every actor process or thread inherits it. CPUs
+ * are kept ordered node by node; compact hands them out in that order, so the
+ * supplier and the cooks share a node, scatter deals actors to the nodes in
+ * turn. Under numa the kitchen and the counter are bound with mbind() to the
+ * node of the first CPU, and each actor may run anywhere on its node.
+ *
+ * With --halls every hall process is first confined to its own slice of the
+ * CPUs with pin_hall(); the policies then place its actors within that slice.
+ *
+ * Actors count their kitchen and counter transactions made from a CPU of
+ * another node than the segment's; pin_print() reports that cross-node share.
+ */
+
+/* Macro Constants */
+#define MPOL_BIND_MODE 2					//MPOL_BIND of <numaif.h>
+#define MPOL_MF_MOVE_FLAG (1 << 1)			//MPOL_MF_MOVE of <numaif.h>
+/* Macro Constants End */
+
+/* Global Variables */
+static int policy = PIN_NONE;
+static int n_cooks;
+static int cpu_count;						//CPUs this run may use
+static int cpus[CPU_SETSIZE];				//those CPUs, node by node
+static int cpu_node[CPU_SETSIZE];			//node of every CPU
+static int node_count;						//nodes with a CPU this run may use
+static int node_id[PIN_MAX_NODES];			//node number of each of them
+static int node_start[PIN_MAX_NODES];		//index of its first CPU in cpus
+static int node_len[PIN_MAX_NODES];			//number of its CPUs
+static int segment_node[SEGMENT_COUNT];		//node holding the pages of each segment
+static const char *policy_names[] = {"none", "compact", "scatter", "numa"};
+/* Global Variables End */
+
+static void read_cpulist(const int node)
+{
+	char path[128];
+	snprintf(path, sizeof(path), PIN_NODE_PATH, node);
+	FILE *file = fopen(path, "r");
+	if(file == NULL)
+		return;
+	int first, last;
+	while(fscanf(file, "%d", &first) == 1)
+	{
+		last = first;
+		int next = fgetc(file);
+		if(next == '-')
+		{
+			if(fscanf(file, "%d", &last) != 1)
+				break;
+			next = fgetc(file);
+		}
+		for(int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+			cpu_node[cpu] = node;
+		if(next != ',')
+			break;
+	}
+	fclose(file);
+}
+
+int pin_parse_policy(const char *name)
+{
+	for(int i = 0; i < (int)(sizeof(policy_names) / sizeof(policy_names[0])); i++)
+		if(strcmp(name, policy_names[i]) == 0)
+			return i;
+	return -1;
+}
+
+/* orders the CPUs this process may use node by node */
+static void pin_topology(void)
+{
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if(sched_getaffinity(0, sizeof(allowed), &allowed) == -1)
+	{
+		char *err_msg = "sched_getaffinity(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+
+	/* without sysfs every CPU is on node 0 */
+	memset(cpu_node, 0, sizeof(cpu_node));
+	for(int node = 0; node < PIN_MAX_NODES; node++)
+		read_cpulist(node);
+
+	cpu_count = 0;
+	node_count = 0;
+	for(int node = 0; node < PIN_MAX_NODES; node++)
+	{
+		node_start[node_count] = cpu_count;
+		for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+			if(CPU_ISSET(cpu, &allowed) && cpu_node[cpu] == node)
+				cpus[cpu_count++] = cpu;
+		if(cpu_count > node_start[node_count])
+		{
+			node_id[node_count] = node;
+			node_len[node_count] = cpu_count - node_start[node_count];
+			node_count++;
+		}
+	}
+}
+
+void pin_init(const int pin_policy, const int N)
+{
+	policy = pin_policy;
+	n_cooks = N;
+	pin_topology();
+
+	/* pages of the segments stay on the node of the first touch, the parent's, unless bound */
+	int cpu = sched_getcpu();
+	int home = (policy == PIN_NUMA || cpu < 0 || cpu >= CPU_SETSIZE) ? node_id[0] : cpu_node[cpu];
+	for(int segment = 0; segment < SEGMENT_COUNT; segment++)
+		segment_node[segment] = home;
+}
+
+void pin_memory(const int segment, void *addr, const size_t size)
+{
+	if(policy != PIN_NUMA)
+		return;
+	unsigned long mask[PIN_MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+	mask[segment_node[segment] / (8 * sizeof(unsigned long))] |= 1UL << (segment_node[segment] % (8 * sizeof(unsigned long)));
+	if(syscall(SYS_mbind, addr, size, MPOL_BIND_MODE, mask, PIN_MAX_NODES + 1, MPOL_MF_MOVE_FLAG) == -1)
+	{
+		/* a kernel without NUMA support still runs, only the pages are not moved */
+		char *err_msg = "mbind(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+	}
+}
+
+void pin_hall(const int hall, const int halls)
+{
+	/* a contiguous run of the node ordered CPUs, so halls share neither CPUs nor, where possible, nodes */
+	pin_topology();
+	int first = (int)((long long)hall * cpu_count / halls);
+	int last = (int)((long long)(hall + 1) * cpu_count / halls);
+	if(last <= first)
+	{
+		first = hall % cpu_count;
+		last = first + 1;
+	}
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for(int k = first; k < last; k++)
+		CPU_SET(cpus[k], &set);
+	if(sched_setaffinity(0, sizeof(set), &set) == -1)
+	{
+		char *err_msg = "sched_setaffinity(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+}
+
+void pin_actor(const int i)
+{
+	if(policy == PIN_NONE)
+		return;
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if(policy == PIN_COMPACT)
+		CPU_SET(cpus[i % cpu_count], &set);
+	else if(policy == PIN_SCATTER)
+	{
+		int node = i % node_count;
+		CPU_SET(cpus[node_start[node] + (i / node_count) % node_len[node]], &set);
+	}
+	else
+	{
+		/* the kitchen node for supplier and cooks, students take the CPUs in order after them */
+		int node = 0;
+		if(i > n_cooks)
+			while(node_id[node] != cpu_node[cpus[i % cpu_count]])
+				node++;
+		for(int k = 0; k < node_len[node]; k++)
+			CPU_SET(cpus[node_start[node] + k], &set);
+	}
+	if(sched_setaffinity(0, sizeof(set), &set) == -1)
+	{
+		char *err_msg = "sched_setaffinity(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+}
+
+int pin_is_remote(const int segment)
+{
+	int cpu = sched_getcpu();
+	return cpu >= 0 && cpu < CPU_SETSIZE && cpu_node[cpu] != segment_node[segment];
+}
+
+void pin_print(void)
+{
+	long long access[SEGMENT_COUNT];
+	long long remote[SEGMENT_COUNT];
+	for(int segment = 0; segment < SEGMENT_COUNT; segment++)
+	{
+		access[segment] = atomic_load(&run_stats->segment_access[segment]);
+		remote[segment] = atomic_load(&run_stats->segment_remote[segment]);
+	}
+
+	char msg[STATS_LINE_SIZE];
+	int len = snprintf(msg, sizeof(msg),
+		"NUMA pin=%s nodes=%d cpus=%d kitchen_node=%d counter_node=%d "
+		"kitchen_access=%lld kitchen_remote=%lld kitchen_remote_share=%.4f "
+		"counter_access=%lld counter_remote=%lld counter_remote_share=%.4f\n",
+		policy_names[policy], node_count, cpu_count, segment_node[SEGMENT_KITCHEN], segment_node[SEGMENT_COUNTER],
+		access[SEGMENT_KITCHEN], remote[SEGMENT_KITCHEN],
+		(access[SEGMENT_KITCHEN] > 0) ? (double)remote[SEGMENT_KITCHEN] / access[SEGMENT_KITCHEN] : 0.0,
+		access[SEGMENT_COUNTER], remote[SEGMENT_COUNTER],
+		(access[SEGMENT_COUNTER] > 0) ? (double)remote[SEGMENT_COUNTER] / access[SEGMENT_COUNTER] : 0.0);
+	write(STDERR_FILENO, msg, len);
+}
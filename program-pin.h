@@ -0,0 +1,39 @@
+#ifndef PROGRAM_PIN_H
+#define PROGRAM_PIN_H
+
+/* Libraries */
+#include <stddef.h>
+/* Libraries End*/
+
+/* Macro Constants */
+#define PIN_MAX_NODES 64					//NUMA nodes looked up in sysfs
+#define PIN_NODE_PATH "/sys/devices/system/node/node%d/cpulist"
+/* Macro Constants End */
+
+/* Enums */
+enum Pin_Policy
+{
+	PIN_NONE,								//the scheduler places every actor
+	PIN_COMPACT,							//one CPU per actor, neighbouring actors on neighbouring CPUs
+	PIN_SCATTER,							//one CPU per actor, neighbouring actors on different nodes
+	PIN_NUMA								//supplier and cooks on the node of the kitchen, students fill the nodes after them
+};
+enum Hall_Segment
+{
+	SEGMENT_KITCHEN,						//Kitchen, shared by supplier and cooks
+	SEGMENT_COUNTER,						//Counter, shared by cooks and students
+	SEGMENT_COUNT
+};
+/* Enums End */
+
+/* Function Definitions */
+int pin_parse_policy(const char*);
+void pin_init(const int, const int);
+void pin_hall(const int, const int);
+void pin_memory(const int, void*, const size_t);
+void pin_actor(const int);
+int pin_is_remote(const int);
+void pin_print(void);
+/* Function Definitions End*/
+
+#endif
@@ -0,0 +1,57 @@
+/* Libraries */
+#include "program-ring.h"
+#include "program-utils.h"
+/* Libraries End*/
+
+/*
+ * Single producer, multi consumer ring of plates. Slots live outside of the
+ * ring header so that several rings can share one shared memory segment.
+ * Callers block on a semaphore only when the ring is empty or full, the
+ * indices themselves are never protected by a lock.
+ */
+
+void ring_init(Plate_Ring *ring, const unsigned int capacity)
+{
+	atomic_init(&ring->head, 0);
+	atomic_init(&ring->tail, 0);
+	ring->capacity = capacity;
+}
+
+int ring_push(Plate_Ring *ring, int *slots, const int plate)
+{
+	unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	unsigned int head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	if(tail - head >= ring->capacity)
+		return FALSE;
+
+	slots[tail % ring->capacity] = plate;
+	atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+	return TRUE;
+}
+
+int ring_pop(Plate_Ring *ring, int *slots, int *plate)
+{
+	unsigned int head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	for(;;)
+	{
+		unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+		if(head == tail)
+			return FALSE;
+
+		/* the slot cannot be reused before head moves past it, so read first */
+		int value = slots[head % ring->capacity];
+		if(atomic_compare_exchange_weak_explicit(&ring->head, &head, head + 1,
+												 memory_order_acq_rel, memory_order_relaxed))
+		{
+			*plate = value;
+			return TRUE;
+		}
+	}
+}
+
+int ring_count(Plate_Ring *ring)
+{
+	unsigned int head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	return (int)(tail - head);
+}
@@ -0,0 +1,35 @@
+#ifndef PROGRAM_RING_H
+#define PROGRAM_RING_H
+
+/* Libraries */
+#include <stdatomic.h>
+#include <stddef.h>
+#include "program-utils.h"
+/* Libraries End*/
+
+/* Shared Memory Structs*/
+struct Plate_Ring
+{
+	CACHE_ALIGNED unsigned int capacity;	//number of slots of the ring, read only
+	CACHE_ALIGNED atomic_uint head;			//index of next plate to take, advanced by cooks
+	CACHE_ALIGNED atomic_uint tail;			//index of next free slot, advanced by supplier
+};
+/* Shared Memory Structs End */
+
+/* Typdefs */
+typedef struct Plate_Ring Plate_Ring;
+/* Typedefs End*/
+
+/* Layout Checks */
+_Static_assert(offsetof(Plate_Ring, head) % CACHE_LINE == 0 && offsetof(Plate_Ring, tail) % CACHE_LINE == 0,
+			   "producer and consumer indices share a cache line");
+/* Layout Checks End */
+
+/* Function Definitions */
+void ring_init(Plate_Ring*, const unsigned int);
+int ring_push(Plate_Ring*, int*, const int);
+int ring_pop(Plate_Ring*, int*, int*);
+int ring_count(Plate_Ring*);
+/* Function Definitions End*/
+
+#endif
@@ -0,0 +1,161 @@
+/* Libraries */
+#define _GNU_SOURCE
+#include "program-serve.h"
+#include "program-utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+/* Libraries End*/
+
+/*
+ * Job socket of --serve. The daemon listens on a Unix stream socket and
+ * serves one connection at a time; a client writes one job per line, in the
+ * syntax of the command line ("-N 3 -M 12 -T 5 -S 4 -L 13 -F input.txt
+ * [-K n] [-B n]"), and reads one JOB line back per job, so a batch pipeline
+ * keeps one connection open for thousands of jobs. The socket file is
+ * removed when the daemon exits.
+ */
+
+/* Global Variables */
+static char serve_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static pid_t serve_owner;					//process that bound the socket and removes it
+/* Global Variables End */
+
+static void serve_exit(void)
+{
+	if(getpid() == serve_owner)
+		unlink(serve_path);
+}
+
+int serve_open(const char *path)
+{
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if(strlen(path) >= sizeof(addr.sun_path))
+	{
+		char *err_msg = "serve_open(): socket path too long!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	strcpy(addr.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(fd == -1)
+	{
+		char *err_msg = "socket(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	/* a socket file left by a daemon that died is stale, one that accepts is not */
+	if(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+	{
+		char *err_msg = "serve_open(): a daemon already serves this socket!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	unlink(path);
+	if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(fd, SERVE_BACKLOG) == -1)
+	{
+		char *err_msg = "bind(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	strcpy(serve_path, path);
+	serve_owner = getpid();
+	atexit(serve_exit);
+	return fd;
+}
+
+FILE *serve_accept(const int listener)
+{
+	int fd;
+	while((fd = accept4(listener, NULL, NULL, SOCK_CLOEXEC)) == -1)
+	{
+		if(errno != EINTR && errno != ECONNABORTED)
+		{
+			char *err_msg = "accept(): unsuccessful!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
+			exit(EXIT_FAILURE);
+		}
+	}
+	FILE *client = fdopen(fd, "r+");
+	if(client == NULL)
+	{
+		char *err_msg = "fdopen(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	return client;
+}
+
+int serve_parse(const char *line, Serve_Job *job)
+{
+	char copy[SERVE_LINE_SIZE];
+	snprintf(copy, sizeof(copy), "%s", line);
+	memset(job, 0, sizeof(Serve_Job));
+
+	int required = 0;					//one bit for each of -N -M -T -S -L -F given
+	char *save;
+	for(char *flag = strtok_r(copy, " \t\r\n", &save); flag != NULL; flag = strtok_r(NULL, " \t\r\n", &save))
+	{
+		char *value = strtok_r(NULL, " \t\r\n", &save);
+		if(value == NULL || strlen(flag) != 2 || flag[0] != '-')
+			return -1;
+		int number = atoi(value);
+		switch (flag[1])
+		{
+		case 'N':
+			job->N = number;
+			required |= 1 << 0;
+			break;
+		case 'M':
+			job->M = number;
+			required |= 1 << 1;
+			break;
+		case 'T':
+			job->T = number;
+			required |= 1 << 2;
+			break;
+		case 'S':
+			job->S = number;
+			required |= 1 << 3;
+			break;
+		case 'L':
+			job->L = number;
+			required |= 1 << 4;
+			break;
+		case 'F':
+			if(strlen(value) >= sizeof(job->input))
+				return -1;
+			strcpy(job->input, value);
+			required |= 1 << 5;
+			break;
+		case 'K':
+			job->K = number;
+			if(number < 1)
+				return -1;
+			break;
+		case 'B':
+			job->B = number;
+			if(number < 1)
+				return -1;
+			break;
+		default:
+			return -1;
+		}
+	}
+	/* a repeated flag does not stand in for a missing one */
+	return (required == (1 << 6) - 1) ? 0 : -1;
+}
+
+int serve_reply(FILE *client, const char *reply, const int len)
+{
+	/* a client that went away ends its connection, not the daemon */
+	if(fwrite(reply, 1, len, client) != (size_t)len || fflush(client) != 0)
+		return -1;
+	return 0;
+}
@@ -0,0 +1,38 @@
+#ifndef PROGRAM_SERVE_H
+#define PROGRAM_SERVE_H
+
+/* Libraries */
+#include <stdio.h>
+/* Libraries End*/
+
+/* Macro Constants */
+#define SERVE_BACKLOG 16					//connections waiting to be accepted
+#define SERVE_LINE_SIZE 8192				//longest job line
+#define SERVE_PATH_SIZE 4096
+#define SERVE_CHECK_NS 100000000LL			//the daemon looks for dead workers this often while a job runs
+#define SERVE_STALL_CHECKS 50				//checks without progress after which a job counts as stalled
+#define SERVE_QUIT "quit"					//job line that stops the daemon
+/* Macro Constants End */
+
+/* Structs */
+struct Serve_Job
+{
+	int N, M, T, S, L;						//parameters of the job, as on the command line
+	int K;									//kitchen capacity, 0 for 2 * L * M + 1
+	int B;									//plates per transaction, 0 for the -B of the daemon
+	char input[SERVE_PATH_SIZE];			//path of the plate input
+};
+/* Structs End */
+
+/* Typdefs */
+typedef struct Serve_Job Serve_Job;
+/* Typedefs End*/
+
+/* Function Definitions */
+int serve_open(const char*);
+FILE *serve_accept(const int);
+int serve_parse(const char*, Serve_Job*);
+int serve_reply(FILE*, const char*, const int);
+/* Function Definitions End*/
+
+#endif
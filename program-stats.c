@@ -0,0 +1,301 @@
+/* Libraries */
+#include "program-stats.h"
+#include "program-utils.h"
+#include "program-metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+/* Libraries End*/
+
+/*
+ * Run statistics shared by every actor. Counters are bumped once per event
+ * with relaxed atomics; wait time is only measured when a semaphore is not
+ * immediately available, so the uncontended path costs one trywait.
+ *
+ * Every wait is also recorded into a log-linear histogram private to the
+ * actor, allocated on the first wait at that point. stats_actor_end() merges
+ * the private histograms into the shared ones, so recording never touches a
+ * cache line another actor writes. Kitchen and counter transactions are
+ * counted the same way. Service points hold spans made of several waits, the
+ * time a student of each priority class took from going to the counter until
+ * it got food; they go into the histograms only, not into blocked time.
+ */
+
+/* Global Variables */
+Run_Stats *run_stats;
+static __thread unsigned int *local_hist[WAIT_COUNT];	//private histograms of this actor
+static __thread long long local_max[WAIT_COUNT];		//private longest waits of this actor
+static __thread long long local_access[SEGMENT_COUNT];	//private transactions on each segment
+static __thread long long local_remote[SEGMENT_COUNT];	//private transactions from another node
+static const struct
+{
+	int role;
+	const char *role_name;
+	const char *sem_name;
+} wait_points[WAIT_COUNT] =
+{
+	{ROLE_SUPPLIER, "supplier", "kitchen.empty_sem"},
+	{ROLE_COOK, "cook", "cook.wake_sem"},
+	{ROLE_COOK, "cook", "shard.b_sem"},
+	{ROLE_STUDENT, "student", "shard.b_sem"},
+	{ROLE_STUDENT, "student", "counter.tray"},
+	{ROLE_STUDENT, "student", "counter.table"},
+	{ROLE_COOK, "cook", "counter.queue_sem"},
+	{ROLE_STUDENT, "student", "counter.queue_sem"},
+	{ROLE_STUDENT, "student", "service.class0"},
+	{ROLE_STUDENT, "student", "service.class1"},
+	{ROLE_STUDENT, "student", "service.class2"},
+	{ROLE_STUDENT, "student", "service.class3"}
+};
+_Static_assert(WAIT_COUNT == WAIT_STUDENT_SERVED + 4, "a priority class has no service point");
+/* Global Variables End */
+
+static int hist_index(const long long value)
+{
+	if(value < (1 << HIST_SUB_BITS))
+		return (value < 0) ? 0 : (int)value;
+	int msb = 63 - __builtin_clzll(value);
+	if(msb >= HIST_MAX_BITS)
+		return HIST_BUCKETS - 1;
+	int shift = msb - HIST_SUB_BITS;
+	return ((shift + 1) << HIST_SUB_BITS) + (int)((value >> shift) & ((1 << HIST_SUB_BITS) - 1));
+}
+
+static long long hist_value(const int index)
+{
+	if(index < (1 << HIST_SUB_BITS))
+		return index;
+	int shift = (index >> HIST_SUB_BITS) - 1;
+	long long sub = index & ((1 << HIST_SUB_BITS) - 1);
+	return (((1LL << HIST_SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+static void hist_record(const int point, const long long value)
+{
+	if(local_hist[point] == NULL && (local_hist[point] = calloc(HIST_BUCKETS, sizeof(unsigned int))) == NULL)
+		return;
+	local_hist[point][hist_index(value)]++;
+	if(value > local_max[point])
+		local_max[point] = value;
+}
+
+void stats_init(Run_Stats *stats)
+{
+	memset(stats, 0, sizeof(Run_Stats));
+	run_stats = stats;
+}
+
+long long stats_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int stats_trywait(Sync_Sem *sem, const int point)
+{
+	if(sync_trywait(sem) == -1)
+		return -1;
+	hist_record(point, 0);
+	return 0;
+}
+
+int stats_wait(Sync_Sem *sem, const int point)
+{
+	if(stats_trywait(sem, point) == 0)
+		return 0;
+
+	long long begin = stats_now();
+	int wait_stat = sync_wait(sem);
+	stats_record(point, stats_now() - begin);
+	return wait_stat;
+}
+
+void stats_record(const int point, const long long waited)
+{
+	atomic_fetch_add_explicit(&run_stats->wait_ns[wait_points[point].role].value, waited, memory_order_relaxed);
+	metrics_wait(waited);
+	hist_record(point, waited);
+}
+
+void stats_span(const int point, const long long span)
+{
+	hist_record(point, span);
+}
+
+void stats_start(const int actors, const int pshared)
+{
+	run_stats->spawn_ns = stats_now();
+	sync_barrier_init(&run_stats->start_barrier, pshared, actors);
+}
+
+void stats_actor_start(void)
+{
+	/* the last actor ready starts the clock, startup is not part of the run */
+	if(sync_barrier_arrive(&run_stats->start_barrier))
+	{
+		run_stats->start_ns = stats_now();
+		sync_barrier_open(&run_stats->start_barrier);
+	}
+	else
+		sync_barrier_wait(&run_stats->start_barrier);
+}
+
+void stats_access(const int segment)
+{
+	local_access[segment]++;
+	if(pin_is_remote(segment))
+		local_remote[segment]++;
+}
+
+void stats_actor_end(void)
+{
+	for(int segment = 0; segment < SEGMENT_COUNT; segment++)
+	{
+		atomic_fetch_add_explicit(&run_stats->segment_access[segment], local_access[segment], memory_order_relaxed);
+		atomic_fetch_add_explicit(&run_stats->segment_remote[segment], local_remote[segment], memory_order_relaxed);
+		local_access[segment] = 0;
+		local_remote[segment] = 0;
+	}
+	for(int point = 0; point < WAIT_COUNT; point++)
+	{
+		if(local_hist[point] == NULL)
+			continue;
+		for(int i = 0; i < HIST_BUCKETS; i++)
+			if(local_hist[point][i] != 0)
+				atomic_fetch_add_explicit(&run_stats->wait_hist[point][i], local_hist[point][i], memory_order_relaxed);
+
+		long long max = atomic_load(&run_stats->wait_max[point]);
+		while(local_max[point] > max && 
+			  !atomic_compare_exchange_weak(&run_stats->wait_max[point], &max, local_max[point]));
+
+		free(local_hist[point]);
+		local_hist[point] = NULL;
+		local_max[point] = 0;
+	}
+}
+
+void stats_print_latency(void)
+{
+	static const double quantiles[] = {0.5, 0.99, 0.999};
+	for(int point = 0; point < WAIT_COUNT; point++)
+	{
+		long long total = 0;
+		for(int i = 0; i < HIST_BUCKETS; i++)
+			total += atomic_load(&run_stats->wait_hist[point][i]);
+		if(total == 0)
+			continue;
+
+		long long values[3];
+		long long seen = 0;
+		int q = 0;
+		for(int i = 0; i < HIST_BUCKETS && q < 3; i++)
+		{
+			seen += atomic_load(&run_stats->wait_hist[point][i]);
+			while(q < 3 && seen >= (long long)(quantiles[q] * total + 0.5) && seen > 0)
+				values[q++] = hist_value(i);
+		}
+		while(q < 3)
+			values[q++] = atomic_load(&run_stats->wait_max[point]);
+
+		char msg[STATS_LINE_SIZE];
+		int len = snprintf(msg, sizeof(msg), "WAIT role=%s sem=%s count=%lld p50_ns=%lld p99_ns=%lld p999_ns=%lld max_ns=%lld\n",
+						   wait_points[point].role_name, wait_points[point].sem_name, total,
+						   values[0], values[1], values[2], atomic_load(&run_stats->wait_max[point]));
+		write(STDERR_FILENO, msg, len);
+	}
+}
+
+int stats_format(char *msg, const size_t size, const int mode, const int N, const int M, const int T, const int S,
+		const int L, const int K)
+{
+	double wall = (run_stats->end_ns - run_stats->start_ns) / 1e9;
+	if(wall <= 0)
+		wall = 1e-9;
+	int actors[ROLE_COUNT] = {1, N, M};
+	double util[ROLE_COUNT];
+	for(int role = 0; role < ROLE_COUNT; role++)
+	{
+		util[role] = 1.0 - (atomic_load(&run_stats->wait_ns[role].value) / 1e9) / (actors[role] * wall);
+		if(util[role] < 0)
+			util[role] = 0;
+	}
+
+	/* waits that found the kitchen full, the others took a free place at once */
+	long long kitchen_full = 0;
+	for(int i = 1; i < HIST_BUCKETS; i++)
+		kitchen_full += atomic_load(&run_stats->wait_hist[WAIT_SUPPLIER_EMPTY][i]);
+
+	int len = snprintf(msg, size,
+		"mode=%s sync=%s N=%d M=%d T=%d S=%d L=%d K=%d ready_s=%.6f wall_s=%.6f "
+		"delivered=%ld plates=%ld plates_per_s=%.1f trays=%ld trays_per_s=%.1f meals=%ld meals_per_s=%.1f "
+		"supplier_util=%.4f cook_util=%.4f student_util=%.4f supplier_blocked_s=%.6f kitchen_full=%lld\n",
+		(mode == MODE_DES) ? "des" : (mode == MODE_THREADS) ? "threads" : "processes", sync_kind_name(), N, M, T, S, L, K,
+		(run_stats->start_ns - run_stats->spawn_ns) / 1e9, wall,
+		atomic_load(&run_stats->plates_delivered),
+		atomic_load(&run_stats->plates_served), atomic_load(&run_stats->plates_served) / wall,
+		atomic_load(&run_stats->trays_taken), atomic_load(&run_stats->trays_taken) / wall,
+		atomic_load(&run_stats->meals), atomic_load(&run_stats->meals) / wall,
+		util[ROLE_SUPPLIER], util[ROLE_COOK], util[ROLE_STUDENT],
+		atomic_load(&run_stats->wait_ns[ROLE_SUPPLIER].value) / 1e9, kitchen_full);
+	return ((size_t)len < size) ? len : (int)size - 1;
+}
+
+void stats_print(const int hall, const int mode, const int N, const int M, const int T, const int S, const int L,
+		const int K)
+{
+	char msg[STATS_LINE_SIZE];
+	int len = (hall >= 0) ? snprintf(msg, sizeof(msg), "STATS hall=%d ", hall) : snprintf(msg, sizeof(msg), "STATS ");
+	len += stats_format(msg + len, sizeof(msg) - len, mode, N, M, T, S, L, K);
+	write(STDERR_FILENO, msg, len);
+}
+
+void stats_hall_result(Hall_Result *result)
+{
+	result->is_done = TRUE;
+	result->start_ns = run_stats->start_ns;
+	result->end_ns = run_stats->end_ns;
+	result->plates_delivered = atomic_load(&run_stats->plates_delivered);
+	result->plates_served = atomic_load(&run_stats->plates_served);
+	result->trays_taken = atomic_load(&run_stats->trays_taken);
+	result->meals = atomic_load(&run_stats->meals);
+	result->supplier_blocked_ns = atomic_load(&run_stats->wait_ns[ROLE_SUPPLIER].value);
+}
+
+void stats_print_halls(const Hall_Result *results, const int halls, const int failed)
+{
+	/* rates of all halls together, from the first hall that started to the last that finished */
+	int is_first = TRUE;
+	long long start_ns = 0;
+	long long end_ns = 0;
+	long delivered = 0, served = 0, trays = 0, meals = 0;
+	long long blocked_ns = 0;
+	for(int h = 0; h < halls; h++)
+	{
+		const Hall_Result *result = &results[h];
+		if(!result->is_done)
+			continue;
+		if(is_first || result->start_ns < start_ns)
+			start_ns = result->start_ns;
+		is_first = FALSE;
+		if(result->end_ns > end_ns)
+			end_ns = result->end_ns;
+		delivered += result->plates_delivered;
+		served += result->plates_served;
+		trays += result->trays_taken;
+		meals += result->meals;
+		blocked_ns += result->supplier_blocked_ns;
+	}
+	double wall = (end_ns - start_ns) / 1e9;
+	if(wall <= 0)
+		wall = 1e-9;
+
+	char msg[STATS_LINE_SIZE];
+	int len = snprintf(msg, sizeof(msg),
+		"HALLS halls=%d failed=%d wall_s=%.6f delivered=%ld plates=%ld plates_per_s=%.1f trays=%ld trays_per_s=%.1f "
+		"meals=%ld meals_per_s=%.1f supplier_blocked_s=%.6f\n",
+		halls, failed, wall, delivered, served, served / wall, trays, trays / wall, meals, meals / wall, blocked_ns / 1e9);
+	write(STDERR_FILENO, msg, len);
+}
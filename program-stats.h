@@ -0,0 +1,103 @@
+#ifndef PROGRAM_STATS_H
+#define PROGRAM_STATS_H
+
+/* Libraries */
+#include <stddef.h>
+#include <stdatomic.h>
+#include "program-utils.h"
+#include "program-sync.h"
+#include "program-pin.h"
+/* Libraries End*/
+
+/* Macro Constants */
+#define STATS_LINE_SIZE 1024
+#define HIST_SUB_BITS 4							//16 sub-buckets per power of two, ~6% error
+#define HIST_MAX_BITS 36						//waits longer than ~68s share the last bucket
+#define HIST_BUCKETS ((HIST_MAX_BITS - HIST_SUB_BITS + 1) << HIST_SUB_BITS)
+/* Macro Constants End */
+
+/* Enums */
+enum Role
+{
+	ROLE_SUPPLIER,
+	ROLE_COOK,
+	ROLE_STUDENT,
+	ROLE_COUNT
+};
+enum Wait_Point
+{
+	WAIT_SUPPLIER_EMPTY,					//supplier waits for space in the kitchen
+	WAIT_COOK_PLATE,						//cook waits for a plate that has a place at the counter
+	WAIT_COOK_COUNTER,						//cook waits for the lock of a counter shard
+	WAIT_STUDENT_COUNTER,					//student waits for the lock of a counter shard
+	WAIT_STUDENT_TRAY,						//student waits for a full tray
+	WAIT_STUDENT_TABLE,						//student waits for an empty table
+	WAIT_COOK_QUEUE,						//cook waits for the lock of the tray queue
+	WAIT_STUDENT_QUEUE,						//student waits for the lock of the tray queue
+	WAIT_STUDENT_SERVED,					//student went to the counter until it got food, one point per class
+	WAIT_COUNT = WAIT_STUDENT_SERVED + PRIORITY_MAX
+};
+/* Enums End */
+
+/* Shared Memory Structs*/
+struct Padded_Counter
+{
+	CACHE_ALIGNED atomic_llong value;		//counter alone on its cache line
+};
+struct Run_Stats
+{
+	long long spawn_ns;						//when the first actor was spawned
+	long long start_ns;						//when every actor was ready and they started
+	long long end_ns;						//when the last actor finished
+	CACHE_ALIGNED atomic_long plates_delivered;	//plates put into the kitchen by the supplier
+	CACHE_ALIGNED atomic_long plates_served;	//plates put on the counter by cooks
+	CACHE_ALIGNED atomic_long trays_taken;		//trays taken from the counter by students
+	CACHE_ALIGNED atomic_long meals;			//meals eaten at tables
+	struct Padded_Counter wait_ns[ROLE_COUNT];	//time actors of each role spent blocked
+	atomic_llong wait_max[WAIT_COUNT];		//longest wait at each wait point
+	atomic_llong wait_hist[WAIT_COUNT][HIST_BUCKETS];	//merged wait histograms, in ns
+	atomic_llong segment_access[SEGMENT_COUNT];	//kitchen and counter transactions of the actors
+	atomic_llong segment_remote[SEGMENT_COUNT];	//those made from a CPU on another node than the segment
+	CACHE_ALIGNED Sync_Barrier start_barrier;	//actors wait here until all of them are ready
+};
+struct Hall_Result
+{
+	CACHE_ALIGNED int is_done;				//whether the hall got to the end and filled the rest
+	long long start_ns;						//when the actors of the hall started, virtual under des
+	long long end_ns;						//when the last actor of the hall finished
+	long plates_delivered;					//totals of the hall, copied from its Run_Stats
+	long plates_served;
+	long trays_taken;
+	long meals;
+	long long supplier_blocked_ns;			//time the supplier of the hall waited for kitchen space
+};
+/* Shared Memory Structs End */
+
+/* Typdefs */
+typedef struct Run_Stats Run_Stats;
+typedef struct Hall_Result Hall_Result;
+/* Typedefs End*/
+
+/* Global Variables */
+extern Run_Stats *run_stats;				//shared statistics of the run
+/* Global Variables End */
+
+/* Function Definitions */
+void stats_init(Run_Stats*);
+long long stats_now(void);
+int stats_trywait(Sync_Sem*, const int);
+int stats_wait(Sync_Sem*, const int);
+void stats_record(const int, const long long);
+void stats_span(const int, const long long);
+void stats_access(const int);
+int stats_format(char*, const size_t, const int, const int, const int, const int, const int, const int, const int);
+void stats_print(const int, const int, const int, const int, const int, const int, const int, const int);
+void stats_hall_result(Hall_Result*);
+void stats_print_halls(const Hall_Result*, const int, const int);
+void stats_start(const int, const int);
+void stats_actor_start(void);
+void stats_actor_end(void);
+void stats_print_latency(void);
+/* Function Definitions End*/
+
+#endif
@@ -0,0 +1,197 @@
+/* Libraries */
+#include "program-sync.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+/* Libraries End*/
+
+/*
+ * Counting semaphore of the handoffs. With SYNC_FUTEX the count is a plain
+ * atomic word: taking it is a compare and swap, a waiter first spins on it
+ * with a CPU pause and only then sleeps in futex(). The spin budget of each
+ * semaphore follows the waits that succeeded while spinning and shrinks
+ * when spinning did not help; on a single CPU nobody spins. A post is one
+ * atomic add and a futex wake only if somebody may be asleep. SYNC_POSIX
+ * keeps sem_t behind the same calls.
+ *
+ * The start barrier is always a futex word: the last actor to arrive opens
+ * it once and wakes every waiter with one call.
+ */
+
+/* Global Variables */
+static int sync_kind = SYNC_FUTEX;				//chosen once before the segments are set up
+static int can_spin = 1;						//more than one CPU, a spinning waiter can be helped
+static const char *kind_names[] = {"futex", "posix"};
+/* Global Variables End */
+
+static long futex(atomic_int *word, const int pshared, const int op, const int value, const struct timespec *timeout)
+{
+	return syscall(SYS_futex, (int *)word, pshared ? op : (op | FUTEX_PRIVATE_FLAG), value, timeout, NULL, 0);
+}
+
+static long long monotonic_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int sync_parse_kind(const char *name)
+{
+	for(int i = 0; i < (int)(sizeof(kind_names) / sizeof(kind_names[0])); i++)
+		if(strcmp(name, kind_names[i]) == 0)
+			return i;
+	return -1;
+}
+
+void sync_select(const int kind)
+{
+	sync_kind = kind;
+	can_spin = (sysconf(_SC_NPROCESSORS_ONLN) > 1);
+}
+
+const char *sync_kind_name(void)
+{
+	return kind_names[sync_kind];
+}
+
+int sync_init(Sync_Sem *s, const int pshared, const unsigned int value)
+{
+	s->pshared = pshared;
+	atomic_init(&s->waiters, 0);
+	atomic_init(&s->spin, 0);
+	if(sync_kind == SYNC_POSIX)
+		return sem_init(&s->sem, pshared, value);
+	if(value > INT_MAX)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	atomic_init(&s->value, (int)value);
+	return 0;
+}
+
+int sync_trywait(Sync_Sem *s)
+{
+	if(sync_kind == SYNC_POSIX)
+		return sem_trywait(&s->sem);
+	int value = atomic_load_explicit(&s->value, memory_order_relaxed);
+	while(value > 0)
+	{
+		if(atomic_compare_exchange_weak(&s->value, &value, value - 1))
+			return 0;
+	}
+	errno = EAGAIN;
+	return -1;
+}
+
+static int futex_wait(Sync_Sem *s, const long long timeout_ns)
+{
+	if(sync_trywait(s) == 0)
+		return 0;
+
+	if(can_spin)
+	{
+		int spin = atomic_load_explicit(&s->spin, memory_order_relaxed);
+		int limit = (spin + SYNC_SPIN_MIN < SYNC_SPIN_MAX) ? spin + SYNC_SPIN_MIN : SYNC_SPIN_MAX;
+		for(int i = 1; i <= limit; i++)
+		{
+			cpu_relax();
+			if(atomic_load_explicit(&s->value, memory_order_relaxed) > 0 && sync_trywait(s) == 0)
+			{
+				/* a budget of twice this wait would have been enough */
+				atomic_store_explicit(&s->spin, spin + (2 * i - spin) / 8, memory_order_relaxed);
+				return 0;
+			}
+		}
+		atomic_store_explicit(&s->spin, spin / 2, memory_order_relaxed);
+	}
+
+	/* a post after the waiter is counted wakes it, or changes value before the futex sleeps */
+	long long deadline = (timeout_ns < 0) ? -1 : monotonic_ns() + timeout_ns;
+	atomic_fetch_add(&s->waiters, 1);
+	while(sync_trywait(s) == -1)
+	{
+		struct timespec timeout;
+		if(deadline >= 0)
+		{
+			long long left = deadline - monotonic_ns();
+			if(left <= 0)
+			{
+				atomic_fetch_sub(&s->waiters, 1);
+				errno = ETIMEDOUT;
+				return -1;
+			}
+			timeout.tv_sec = left / 1000000000LL;
+			timeout.tv_nsec = left % 1000000000LL;
+		}
+		if(futex(&s->value, s->pshared, FUTEX_WAIT, 0, (deadline >= 0) ? &timeout : NULL) == -1 &&
+		   errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT)
+		{
+			atomic_fetch_sub(&s->waiters, 1);
+			return -1;
+		}
+	}
+	atomic_fetch_sub(&s->waiters, 1);
+	return 0;
+}
+
+int sync_wait(Sync_Sem *s)
+{
+	if(sync_kind == SYNC_POSIX)
+		return sem_wait(&s->sem);
+	return futex_wait(s, -1);
+}
+
+int sync_timedwait(Sync_Sem *s, const long long timeout_ns)
+{
+	if(sync_kind == SYNC_POSIX)
+	{
+		struct timespec deadline;
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		long long ns = deadline.tv_nsec + timeout_ns;
+		deadline.tv_sec += ns / 1000000000LL;
+		deadline.tv_nsec = ns % 1000000000LL;
+		return sem_timedwait(&s->sem, &deadline);
+	}
+	return futex_wait(s, timeout_ns);
+}
+
+int sync_post(Sync_Sem *s)
+{
+	if(sync_kind == SYNC_POSIX)
+		return sem_post(&s->sem);
+	atomic_fetch_add(&s->value, 1);
+	if(atomic_load(&s->waiters) > 0 && futex(&s->value, s->pshared, FUTEX_WAKE, 1, NULL) == -1)
+		return -1;
+	return 0;
+}
+
+void sync_barrier_init(Sync_Barrier *b, const int pshared, const int count)
+{
+	atomic_init(&b->arrived, 0);
+	atomic_init(&b->is_open, 0);
+	b->count = count;
+	b->pshared = pshared;
+}
+
+int sync_barrier_arrive(Sync_Barrier *b)
+{
+	return atomic_fetch_add(&b->arrived, 1) + 1 == b->count;
+}
+
+void sync_barrier_open(Sync_Barrier *b)
+{
+	atomic_store(&b->is_open, 1);
+	futex(&b->is_open, b->pshared, FUTEX_WAKE, INT_MAX, NULL);
+}
+
+void sync_barrier_wait(Sync_Barrier *b)
+{
+	while(!atomic_load(&b->is_open))
+		futex(&b->is_open, b->pshared, FUTEX_WAIT, 0, NULL);
+}
@@ -0,0 +1,70 @@
+#ifndef PROGRAM_SYNC_H
+#define PROGRAM_SYNC_H
+
+/* Libraries */
+#include <stdatomic.h>
+#include <semaphore.h>
+/* Libraries End*/
+
+/* Macro Constants */
+#define SYNC_SPIN_MIN 16						//pauses every waiter tries before its first sleep
+#define SYNC_SPIN_MAX 2000						//upper bound of the adaptive spin, ~ tens of microseconds
+/* Macro Constants End */
+
+/* Enums */
+enum Sync_Kind
+{
+	SYNC_FUTEX,								//spin on the count, then sleep on it with futex()
+	SYNC_POSIX								//plain sem_t, for comparison
+};
+/* Enums End */
+
+/* Shared Memory Structs*/
+struct Sync_Sem
+{
+	atomic_int value;						//count of the semaphore, the futex word
+	atomic_int waiters;						//waiters asleep or about to sleep on value
+	atomic_int spin;						//pauses a waiter may spin, adapted to past waits
+	int pshared;							//shared between processes, selects the futex operations
+	sem_t sem;								//the semaphore itself under SYNC_POSIX
+};
+struct Sync_Barrier
+{
+	atomic_int arrived;						//actors that reached the barrier
+	atomic_int is_open;						//set by the last one, the futex word of the others
+	int count;								//actors to wait for
+	int pshared;							//shared between processes, selects the futex operations
+};
+/* Shared Memory Structs End */
+
+/* Typdefs */
+typedef struct Sync_Sem Sync_Sem;
+typedef struct Sync_Barrier Sync_Barrier;
+/* Typedefs End*/
+
+/* pause of a spinning waiter, lets the sibling hyperthread run */
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ volatile("yield");
+#endif
+}
+
+/* Function Definitions */
+int sync_parse_kind(const char*);
+void sync_select(const int);
+const char *sync_kind_name(void);
+int sync_init(Sync_Sem*, const int, const unsigned int);
+int sync_trywait(Sync_Sem*);
+int sync_wait(Sync_Sem*);
+int sync_timedwait(Sync_Sem*, const long long);
+int sync_post(Sync_Sem*);
+void sync_barrier_init(Sync_Barrier*, const int, const int);
+int sync_barrier_arrive(Sync_Barrier*);
+void sync_barrier_open(Sync_Barrier*);
+void sync_barrier_wait(Sync_Barrier*);
+/* Function Definitions End*/
+
+#endif
@@ -0,0 +1,162 @@
+/* Libraries */
+#include "program-tables.h"
+#include "program-stats.h"
+#include "program-utils.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+/* Libraries End*/
+
+/*
+ * Tables of the mess hall. free_sem counts the free tables so a student
+ * blocks only when every table is taken; after the wait a free bit is known
+ * to exist and is claimed with a CAS on its bitmap word. table_take() and
+ * table_put() are the bitmap alone, for callers that keep their own clock.
+ * Students start the search at their own word and bit, so with enough
+ * tables they rarely race for the same table. The bitmap is padded to whole
+ * cache lines and followed by one usage record per table.
+ */
+
+static unsigned int padded_words(const unsigned int count)
+{
+	unsigned int words = (count + TABLE_WORD_BITS - 1) / TABLE_WORD_BITS;
+	unsigned int per_line = CACHE_LINE / sizeof(atomic_ullong);
+	return ((words + per_line - 1) / per_line) * per_line;
+}
+
+static Table_Usage *table_usage(Table_Set *set, const int table)
+{
+	return (Table_Usage *)(set->used + padded_words(set->count)) + table;
+}
+
+static unsigned long long word_mask(Table_Set *set, const unsigned int word)
+{
+	unsigned int left = set->count - word * TABLE_WORD_BITS;
+	return (left >= TABLE_WORD_BITS) ? ~0ULL : (1ULL << left) - 1;
+}
+
+size_t tables_size(const unsigned int count)
+{
+	return sizeof(Table_Set) + padded_words(count) * sizeof(atomic_ullong) + count * sizeof(Table_Usage);
+}
+
+void tables_init(Table_Set *set, const unsigned int count, const int pshared)
+{
+	set->count = count;
+	set->words = (count + TABLE_WORD_BITS - 1) / TABLE_WORD_BITS;
+	atomic_init(&set->empty, count);
+	for(unsigned int i = 0; i < padded_words(count); i++)
+		atomic_init(&set->used[i], 0);
+	for(unsigned int i = 0; i < count; i++)
+	{
+		atomic_init(&table_usage(set, i)->meals, 0);
+		atomic_init(&table_usage(set, i)->busy_ns, 0);
+		table_usage(set, i)->since_ns = 0;
+	}
+	if(sync_init(&set->free_sem, pshared, count) == -1)
+	{
+		char *err_msg = "sync_init(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+}
+
+int table_acquire(Table_Set *set, const int hint)
+{
+	if(stats_wait(&set->free_sem, WAIT_STUDENT_TABLE) == -1)
+	{
+		char *err_msg = "sync_wait(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+
+	/* the semaphore reserved a table, only the bit to claim is searched for */
+	int table;
+	while((table = table_take(set, hint, stats_now())) == -1);
+	return table;
+}
+
+void table_release(Table_Set *set, const int table)
+{
+	table_put(set, table, stats_now());
+	if(sync_post(&set->free_sem) == -1)
+	{
+		char *err_msg = "sync_post(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+}
+
+int table_take(Table_Set *set, const int hint, const long long now)
+{
+	unsigned int start = (unsigned int)hint % set->words;
+	unsigned int spread = (set->count < TABLE_WORD_BITS) ? set->count : TABLE_WORD_BITS;
+	unsigned long long above = ~0ULL << (((unsigned int)hint / set->words) % spread);
+	for(unsigned int k = 0; k < set->words; k++)
+	{
+		unsigned int word = (start + k) % set->words;
+		unsigned long long bits = atomic_load_explicit(&set->used[word], memory_order_relaxed);
+		unsigned long long free_bits;
+		while((free_bits = ~bits & word_mask(set, word)) != 0)
+		{
+			unsigned long long preferred = (free_bits & above) ? (free_bits & above) : free_bits;
+			unsigned long long bit = preferred & -preferred;
+			if(atomic_compare_exchange_weak(&set->used[word], &bits, bits | bit))
+			{
+				int table = word * TABLE_WORD_BITS + __builtin_ctzll(bit);
+				atomic_fetch_sub(&set->empty, 1);
+				atomic_fetch_add_explicit(&table_usage(set, table)->meals, 1, memory_order_relaxed);
+				table_usage(set, table)->since_ns = now;
+				return table;
+			}
+		}
+	}
+	return -1;
+}
+
+void table_put(Table_Set *set, const int table, const long long now)
+{
+	Table_Usage *usage = table_usage(set, table);
+	atomic_fetch_add_explicit(&usage->busy_ns, now - usage->since_ns, memory_order_relaxed);
+	atomic_fetch_and(&set->used[table / TABLE_WORD_BITS], ~(1ULL << (table % TABLE_WORD_BITS)));
+	atomic_fetch_add(&set->empty, 1);
+}
+
+int tables_empty(Table_Set *set)
+{
+	return atomic_load_explicit(&set->empty, memory_order_relaxed);
+}
+
+void tables_print(Table_Set *set, const int hall, const long long wall_ns)
+{
+	/* one summary line whatever the number of tables, the busiest is the one with the most busy time */
+	double wall = (wall_ns > 0) ? wall_ns / 1e9 : 1e-9;
+	long long meals = 0, busiest_meals = 0;
+	long long total_ns = 0, min_ns = 0, max_ns = 0;
+	unsigned int busiest = 0;
+	for(unsigned int i = 0; i < set->count; i++)
+	{
+		Table_Usage *usage = table_usage(set, i);
+		long long busy_ns = atomic_load(&usage->busy_ns);
+		meals += atomic_load(&usage->meals);
+		total_ns += busy_ns;
+		if(i == 0 || busy_ns < min_ns)
+			min_ns = busy_ns;
+		if(i == 0 || busy_ns > max_ns)
+		{
+			max_ns = busy_ns;
+			busiest = i;
+			busiest_meals = atomic_load(&usage->meals);
+		}
+	}
+
+	char msg[STATS_LINE_SIZE];
+	int len = (hall >= 0) ? snprintf(msg, sizeof(msg), "TABLES hall=%d ", hall) : snprintf(msg, sizeof(msg), "TABLES ");
+	len += snprintf(msg + len, sizeof(msg) - len,
+					"count=%u meals=%lld occupancy_min=%.4f occupancy_mean=%.4f occupancy_max=%.4f "
+					"busiest=%u busiest_meals=%lld\n",
+					set->count, meals, (min_ns / 1e9) / wall, (total_ns / 1e9) / set->count / wall,
+					(max_ns / 1e9) / wall, busiest, busiest_meals);
+	write(STDERR_FILENO, msg, len);
+}
@@ -0,0 +1,52 @@
+#ifndef PROGRAM_TABLES_H
+#define PROGRAM_TABLES_H
+
+/* Libraries */
+#include <stdatomic.h>
+#include <stddef.h>
+#include "program-utils.h"
+#include "program-sync.h"
+/* Libraries End*/
+
+/* Macro Constants */
+#define TABLE_WORD_BITS 64
+/* Macro Constants End */
+
+/* Shared Memory Structs*/
+struct Table_Usage
+{
+	CACHE_ALIGNED atomic_llong meals;		//meals eaten at this table
+	atomic_llong busy_ns;					//time this table was taken
+	long long since_ns;						//when the current student sat down, written by that student
+};
+struct Table_Set
+{
+	CACHE_ALIGNED Sync_Sem free_sem;		//number of free tables, students block here only when all are taken
+	CACHE_ALIGNED atomic_int empty;			//number of free tables, for reports
+	unsigned int count;						//number of tables, read only
+	unsigned int words;						//number of words of the bitmap, read only
+	CACHE_ALIGNED atomic_ullong used[];		//one bit per table, set while a student sits there, followed by usages
+};
+/* Shared Memory Structs End */
+
+/* Typdefs */
+typedef struct Table_Usage Table_Usage;
+typedef struct Table_Set Table_Set;
+/* Typedefs End*/
+
+/* Layout Checks */
+_Static_assert(sizeof(Table_Usage) % CACHE_LINE == 0, "usages of neighbouring tables share a cache line");
+/* Layout Checks End */
+
+/* Function Definitions */
+size_t tables_size(const unsigned int);
+void tables_init(Table_Set*, const unsigned int, const int);
+int table_acquire(Table_Set*, const int);
+void table_release(Table_Set*, const int);
+int table_take(Table_Set*, const int, const long long);
+void table_put(Table_Set*, const int, const long long);
+int tables_empty(Table_Set*);
+void tables_print(Table_Set*, const int, const long long);
+/* Function Definitions End*/
+
+#endif
@@ -0,0 +1,112 @@
+/* Libraries */
+#include "program-trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+/* Libraries End*/
+
+/*
+ * Binary trace of the events. Every actor process or thread owns one file of
+ * fixed-size records in the trace directory and writes it through a shared
+ * mapping of TRACE_CHUNK records; a full window is unmapped and the next one
+ * is mapped further into the file. Closing cuts the file to the records
+ * written. Timestamps are CLOCK_MONOTONIC, shared by all processes, so the
+ * decoder can merge the files into one timeline.
+ */
+
+/* Global Variables */
+static const char *trace_dir = NULL;			//directory of the trace files, NULL if tracing is off
+static int is_virtual = 0;						//timestamps come from trace_set_time(), not the clock
+static long long virtual_ns = 0;				//current virtual time under --engine=des
+static __thread int trace_fd = -1;				//trace file of this process or thread
+static __thread Trace_Record *trace_window;		//mapped records of the file
+static __thread long long trace_base;			//index in the file of the first mapped record
+static __thread int trace_used;					//records written into the window
+/* Global Variables End */
+
+static void trace_fail(char *err_msg)
+{
+	write(STDERR_FILENO, err_msg, strlen(err_msg));
+	exit(EXIT_FAILURE);
+}
+
+static void map_window(void)
+{
+	size_t window_size = TRACE_CHUNK * sizeof(Trace_Record);
+	if(ftruncate(trace_fd, (off_t)(trace_base + TRACE_CHUNK) * sizeof(Trace_Record)) == -1)
+		trace_fail("ftruncate(): unsuccessful!\n");
+	trace_window = mmap(NULL, window_size, PROT_READ | PROT_WRITE, MAP_SHARED, trace_fd, (off_t)trace_base * sizeof(Trace_Record));
+	if(trace_window == MAP_FAILED)
+		trace_fail("mmap(): unsuccessful!\n");
+	trace_used = 0;
+}
+
+void trace_init(const char *dir)
+{
+	trace_dir = dir;
+	if(dir != NULL && mkdir(dir, 0755) == -1 && errno != EEXIST)
+		trace_fail("mkdir(): unsuccessful!\n");
+	/* the decoder needs the courses to name plates and items */
+	if(dir != NULL)
+		menu_save(dir);
+}
+
+void trace_open(const int actor)
+{
+	if(trace_dir == NULL)
+		return;
+	char path[4096];
+	snprintf(path, sizeof(path), TRACE_FILE, trace_dir, actor);
+	trace_fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(trace_fd == -1)
+		trace_fail("open(): unsuccessful!\n");
+	trace_base = 0;
+	map_window();
+}
+
+int trace_enabled(void)
+{
+	return trace_fd != -1;
+}
+
+void trace_set_time(const long long now)
+{
+	is_virtual = 1;
+	virtual_ns = now;
+}
+
+void trace_write(Trace_Record *record)
+{
+	if(trace_used == TRACE_CHUNK)
+	{
+		munmap(trace_window, TRACE_CHUNK * sizeof(Trace_Record));
+		trace_base += TRACE_CHUNK;
+		map_window();
+	}
+	if(is_virtual)
+		record->time_ns = virtual_ns;
+	else
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		record->time_ns = (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+	}
+	trace_window[trace_used++] = *record;
+}
+
+void trace_close(void)
+{
+	if(trace_fd == -1)
+		return;
+	munmap(trace_window, TRACE_CHUNK * sizeof(Trace_Record));
+	if(ftruncate(trace_fd, (off_t)(trace_base + trace_used) * sizeof(Trace_Record)) == -1)
+		trace_fail("ftruncate(): unsuccessful!\n");
+	close(trace_fd);
+	trace_fd = -1;
+}
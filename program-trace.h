@@ -0,0 +1,75 @@
+#ifndef PROGRAM_TRACE_H
+#define PROGRAM_TRACE_H
+
+/* Libraries */
+#include <stddef.h>
+#include "program-menu.h"
+/* Libraries End*/
+
+/* Macro Constants */
+#define TRACE_FILE "%s/trace-%d.bin"		//trace of the i-th actor in the trace directory
+#define TRACE_CHUNK 65536					//records mapped at a time, the file grows by this much
+/* Macro Constants End */
+
+/* Enums */
+enum Trace_Role
+{
+	TRACE_SUPPLIER,
+	TRACE_COOK,
+	TRACE_STUDENT,
+	TRACE_ROLE_COUNT
+};
+enum Trace_Code
+{
+	TRACE_NONE,								//unused record, left by an actor that did not close its trace
+	TRACE_SUPPLIER_GOING,
+	TRACE_SUPPLIER_DELIVERED,
+	TRACE_SUPPLIER_DONE,
+	TRACE_COOK_KITCHEN,
+	TRACE_COOK_GOING,
+	TRACE_COOK_PLACED,
+	TRACE_COOK_DONE,
+	TRACE_STUDENT_COUNTER,
+	TRACE_STUDENT_GOT,
+	TRACE_STUDENT_SAT,
+	TRACE_STUDENT_LEFT,
+	TRACE_STUDENT_DONE,
+	TRACE_CODE_COUNT
+};
+/* Enums End */
+
+/* Structs */
+struct Trace_Record
+{
+	long long time_ns;						//monotonic time of the event, virtual time under --engine=des
+	int number;								//cook or student number, 0 for the supplier
+	unsigned char role;						//a Trace_Role
+	unsigned char code;						//a Trace_Code
+	unsigned char course;					//course of the plate carried, see course_of()
+	unsigned char unused;
+	int round;								//meal of a student, 1 based
+	int value;								//students at the counter, table taken or kitchen items left
+	int empty;								//empty tables
+	int items[MENU_MAX];					//items of each course in the kitchen or on the counter the actor saw
+};
+/* Structs End */
+
+/* Typdefs */
+typedef struct Trace_Record Trace_Record;
+/* Typedefs End*/
+
+/* Layout Checks */
+_Static_assert(sizeof(Trace_Record) == 64, "trace files written by another build could not be decoded");
+_Static_assert((TRACE_CHUNK * sizeof(Trace_Record)) % 4096 == 0, "a trace window does not end on a page");
+/* Layout Checks End */
+
+/* Function Definitions */
+void trace_init(const char*);
+void trace_open(const int);
+int trace_enabled(void);
+void trace_set_time(const long long);
+void trace_write(Trace_Record*);
+void trace_close(void);
+/* Function Definitions End*/
+
+#endif
@@ -0,0 +1,110 @@
+/* Libraries */
+#include "program-uring.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+/* Libraries End*/
+
+/*
+ * Minimal io_uring through the raw system calls, no liburing needed: one
+ * ring per process or thread, used for IORING_OP_WRITE at the current file
+ * position. uring_open() fails on kernels without io_uring or where it is
+ * disabled, the caller then writes synchronously.
+ */
+
+static int uring_enter(Uring *ring, const unsigned int submit, const unsigned int wait)
+{
+	for(;;)
+	{
+		long entered = syscall(__NR_io_uring_enter, ring->fd, submit, wait, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+		if(entered != -1 || errno != EINTR)
+			return (int)entered;
+	}
+}
+
+int uring_open(Uring *ring)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	ring->fd = (int)syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+	if(ring->fd == -1)
+		return -1;
+
+	ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if(params.features & IORING_FEAT_SINGLE_MMAP)
+		ring->sq_size = ring->cq_size = (ring->sq_size > ring->cq_size) ? ring->sq_size : ring->cq_size;
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	ring->sq_map = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	ring->cq_map = ring->sq_map;
+	if(ring->sq_map != MAP_FAILED && !(params.features & IORING_FEAT_SINGLE_MMAP))
+		ring->cq_map = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if(ring->sq_map == MAP_FAILED || ring->cq_map == MAP_FAILED || ring->sqes == MAP_FAILED)
+	{
+		if(ring->sq_map != MAP_FAILED)
+			munmap(ring->sq_map, ring->sq_size);
+		if(ring->cq_map != MAP_FAILED && ring->cq_map != ring->sq_map)
+			munmap(ring->cq_map, ring->cq_size);
+		if(ring->sqes != MAP_FAILED)
+			munmap(ring->sqes, ring->sqes_size);
+		close(ring->fd);
+		ring->fd = -1;
+		return -1;
+	}
+
+	char *sq = ring->sq_map;
+	char *cq = ring->cq_map;
+	ring->sq_tail = (unsigned int *)(sq + params.sq_off.tail);
+	ring->sq_mask = (unsigned int *)(sq + params.sq_off.ring_mask);
+	ring->sq_array = (unsigned int *)(sq + params.sq_off.array);
+	ring->cq_head = (unsigned int *)(cq + params.cq_off.head);
+	ring->cq_tail = (unsigned int *)(cq + params.cq_off.tail);
+	ring->cq_mask = (unsigned int *)(cq + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+	return 0;
+}
+
+int uring_write(Uring *ring, const int fd, const char *buf, const size_t len)
+{
+	unsigned int tail = *ring->sq_tail;
+	unsigned int index = tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe = &ring->sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_WRITE;
+	sqe->fd = fd;
+	sqe->addr = (unsigned long)buf;
+	sqe->len = (unsigned int)len;
+	sqe->off = (unsigned long long)-1;		//at the file position, like write()
+	ring->sq_array[index] = index;
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	return (uring_enter(ring, 1, 0) == 1) ? 0 : -1;
+}
+
+int uring_wait(Uring *ring)
+{
+	unsigned int head = *ring->cq_head;
+	while(head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+	{
+		if(uring_enter(ring, 0, 1) == -1)
+			return -errno;
+	}
+	int res = ring->cqes[head & *ring->cq_mask].res;
+	__atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+	return res;
+}
+
+void uring_close(Uring *ring)
+{
+	if(ring->fd == -1)
+		return;
+	munmap(ring->sqes, ring->sqes_size);
+	if(ring->cq_map != ring->sq_map)
+		munmap(ring->cq_map, ring->cq_size);
+	munmap(ring->sq_map, ring->sq_size);
+	close(ring->fd);
+	ring->fd = -1;
+}
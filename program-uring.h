@@ -0,0 +1,44 @@
+#ifndef PROGRAM_URING_H
+#define PROGRAM_URING_H
+
+/* Libraries */
+#include <stddef.h>
+#include <linux/io_uring.h>
+/* Libraries End*/
+
+/* Macro Constants */
+#define URING_ENTRIES 4						//submission queue size, one write is in flight at a time
+/* Macro Constants End */
+
+/* Structs */
+struct Uring
+{
+	int fd;									//ring file descriptor, -1 if not set up
+	unsigned int *sq_tail;					//submission queue, written by us
+	unsigned int *sq_mask;
+	unsigned int *sq_array;
+	struct io_uring_sqe *sqes;
+	unsigned int *cq_head;					//completion queue, written by the kernel
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_cqe *cqes;
+	void *sq_map;							//mappings of the rings and entries, for munmap()
+	void *cq_map;
+	size_t sq_size;
+	size_t cq_size;
+	size_t sqes_size;
+};
+/* Structs End */
+
+/* Typdefs */
+typedef struct Uring Uring;
+/* Typedefs End*/
+
+/* Function Definitions */
+int uring_open(Uring*);
+int uring_write(Uring*, const int, const char*, const size_t);
+int uring_wait(Uring*);
+void uring_close(Uring*);
+/* Function Definitions End*/
+
+#endif
@@ -1,5 +1,10 @@
 /* Libraries */
 #include "program-utils.h"
+#include "program-log.h"
+#include "program-pin.h"
+#include "program-sync.h"
+#include "program-menu.h"
+#include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -15,9 +20,11 @@ int check_constraint(const int N, const int M, const int T, const int S, const i
 		write(STDERR_FILENO, err_msg, strlen(err_msg));
         isPass = FALSE;
     }
-	if(S <= 3)
+	if(S <= menu.count)
 	{
-		char *err_msg = "Error! Constraint: (S > 3)\n";
+		/* a shard holds S / courses trays, at least one */
+		char err_msg[64];
+		snprintf(err_msg, sizeof(err_msg), "Error! Constraint: (S > %d)\n", menu.count);
 		write(STDERR_FILENO, err_msg, strlen(err_msg));
         isPass = FALSE;
     }
@@ -45,50 +52,184 @@ int check_constraint(const int N, const int M, const int T, const int S, const i
 		write(STDERR_FILENO, err_msg, strlen(err_msg));
         isPass = FALSE;
     }
+	if(K < 3)
+	{
+		char *err_msg = "Error! Constraint: (K >= 3)\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+        isPass = FALSE;
+	}
 
     return isPass;
 }
 
-char* handle_options(int argc, char **argv, int *N, int *M, int *T, int *S, int *L)
+const char* handle_options(int argc, char **argv, int *N, int *M, int *T, int *S, int *L, Options *opts)
 {
-    if(argc != 13)
+	static struct option long_options[] =
+	{
+		{"log", required_argument, NULL, 'l'},
+		{"log-backend", required_argument, NULL, 'g'},
+		{"mode", required_argument, NULL, 'm'},
+		{"stats", no_argument, NULL, 's'},
+		{"latency", no_argument, NULL, 'w'},
+		{"shards", required_argument, NULL, 'h'},
+		{"engine", required_argument, NULL, 'e'},
+		{"trace", required_argument, NULL, 't'},
+		{"pin", required_argument, NULL, 'p'},
+		{"sync", required_argument, NULL, 'y'},
+		{"metrics", no_argument, NULL, 'x'},
+		{"halls", required_argument, NULL, 'a'},
+		{"menu", required_argument, NULL, 'u'},
+		{"queue", required_argument, NULL, 'q'},
+		{"priority", required_argument, NULL, 'r'},
+		{"serve", required_argument, NULL, 'v'},
+		{NULL, 0, NULL, 0}
+	};
+    int option;
+    int is_valid = TRUE;
+    int required = 0;				//number of -N -M -T -S -L -F given
+    char *file_name = NULL;
+	opts->log_mode = LOG_SYNC;
+	opts->log_backend = LOG_BACKEND_WRITE;
+	opts->run_mode = MODE_PROCESSES;
+	opts->engine = ENGINE_ACTORS;
+	opts->print_stats = FALSE;
+	opts->print_latency = FALSE;
+	opts->batch = 1;
+	opts->kitchen = 0;
+	opts->shards = 1;
+	opts->trace_dir = NULL;
+	opts->pin_policy = PIN_NONE;
+	opts->sync_kind = SYNC_FUTEX;
+	opts->live_metrics = FALSE;
+	opts->halls = 1;
+	opts->queue_mode = QUEUE_FIFO;
+	opts->classes = 1;
+	opts->serve_path = NULL;
+	menu_parse(MENU_DEFAULT);
+    while ((option = getopt_long(argc, argv, "N:M:T:S:L:F:B:K:", long_options, NULL)) != -1)
+  	{
+		switch (option)
+		{
+		case 'N':
+			*N = atoi(optarg);
+			required++;
+			break;
+		case 'M':
+			*M = atoi(optarg);
+			required++;
+			break;
+		case 'T':
+			*T = atoi(optarg);
+			required++;
+			break;
+		case 'S':
+			*S = atoi(optarg);
+			required++;
+			break;
+		case 'L':
+			*L = atoi(optarg);	
+			required++;
+			break;
+		case 'F':
+			file_name = optarg;
+			required++;
+			break;
+		case 'B':
+			opts->batch = atoi(optarg);
+			is_valid = is_valid && (opts->batch >= 1);
+			break;
+		case 'K':
+			opts->kitchen = atoi(optarg);
+			is_valid = is_valid && (opts->kitchen >= 1);
+			break;
+		case 'h':
+			opts->shards = atoi(optarg);
+			is_valid = is_valid && (opts->shards >= 1);
+			break;
+		case 'l':
+			opts->log_mode = log_parse_mode(optarg);
+			is_valid = is_valid && (opts->log_mode != -1);
+			break;
+		case 'g':
+			opts->log_backend = log_parse_backend(optarg);
+			is_valid = is_valid && (opts->log_backend != -1);
+			break;
+		case 'm':
+			if(strcmp(optarg, "processes") == 0)
+				opts->run_mode = MODE_PROCESSES;
+			else if(strcmp(optarg, "threads") == 0)
+				opts->run_mode = MODE_THREADS;
+			else
+				is_valid = FALSE;
+			break;
+		case 'e':
+			if(strcmp(optarg, "actors") == 0)
+				opts->engine = ENGINE_ACTORS;
+			else if(strcmp(optarg, "des") == 0)
+				opts->engine = ENGINE_DES;
+			else
+				is_valid = FALSE;
+			break;
+		case 's':
+			opts->print_stats = TRUE;
+			break;
+		case 'w':
+			opts->print_latency = TRUE;
+			break;
+		case 't':
+			opts->trace_dir = optarg;
+			break;
+		case 'p':
+			opts->pin_policy = pin_parse_policy(optarg);
+			is_valid = is_valid && (opts->pin_policy != -1);
+			break;
+		case 'y':
+			opts->sync_kind = sync_parse_kind(optarg);
+			is_valid = is_valid && (opts->sync_kind != -1);
+			break;
+		case 'x':
+			opts->live_metrics = TRUE;
+			break;
+		case 'a':
+			opts->halls = atoi(optarg);
+			is_valid = is_valid && (opts->halls >= 1);
+			break;
+		case 'u':
+			is_valid = is_valid && (menu_parse(optarg) == 0);
+			break;
+		case 'q':
+			if(strcmp(optarg, "fifo") == 0)
+				opts->queue_mode = QUEUE_FIFO;
+			else if(strcmp(optarg, "any") == 0)
+				opts->queue_mode = QUEUE_ANY;
+			else
+				is_valid = FALSE;
+			break;
+		case 'r':
+			opts->classes = atoi(optarg);
+			is_valid = is_valid && (opts->classes >= 1) && (opts->classes <= PRIORITY_MAX);
+			break;
+		case 'v':
+			opts->serve_path = optarg;
+			break;
+		default:
+			is_valid = FALSE;
+			break;
+		}
+	}
+	if(opts->serve_path != NULL)
+	{
+		/* the daemon keeps one pool of processes and gets the input with each job */
+		is_valid = is_valid && opts->run_mode == MODE_PROCESSES && opts->engine == ENGINE_ACTORS &&
+				   opts->halls == 1 && opts->trace_dir == NULL && !opts->live_metrics && opts->pin_policy == PIN_NONE;
+		if(file_name == NULL)
+			required++;
+	}
+    if(!is_valid || required != 6 || (file_name == NULL && opts->serve_path == NULL) || optind != argc)
 	{
 		char *err_msg = OPT_USE_ERR;
 		write(STDERR_FILENO, err_msg, strlen(err_msg));
 		exit(EXIT_FAILURE);
 	}
-    int option;
-    char *file_name;
-    while ((option = getopt (argc, argv, "NMTSLF")) != -1)
-  	{
-	    if(option == 'N')
-			*N = atoi(argv[optind]);
-        else if(option == 'M')
-			*M = atoi(argv[optind]);
-		else if(option == 'T')
-			*T = atoi(argv[optind]);
-		else if(option == 'S')
-			*S = atoi(argv[optind]);
-		else if(option == 'L')
-			*L = atoi(argv[optind]);	
-		else if(option == 'F')
-			file_name = argv[optind];
-		else
-        {
-            char *err_msg = OPT_USE_ERR;
-			write(STDERR_FILENO, err_msg, strlen(err_msg));
-		    exit(EXIT_FAILURE);
-        }			
-	}
     return file_name;
 }
-
-int find_min(const int P, const int C, const int D)
-{
-	if (P <= C && P <= D) 
-        return P;
-    else if (C <= P && C <= D) 
-        return C;
-    else
-        return D;
-}
\ No newline at end of file
@@ -2,16 +2,52 @@
 #define PROGRAM_UTILS_H
 
 /* Macro Constants */
-#define OPT_USE_ERR "Wrong input option usage! Use such: ./program -N 3 -M 12 -T 5 -S 4 -L 13\n"
+#define OPT_USE_ERR "Wrong input option usage! Use such: ./program -N 3 -M 12 -T 5 -S 4 -L 13 -F input.txt [-B 1] [-K plates] [--shards=1] [--log=off|buffered|sync] [--log-backend=write|uring] [--mode=processes|threads] [--engine=actors|des] [--stats] [--latency] [--trace=DIR] [--pin=none|compact|scatter|numa] [--sync=futex|posix] [--metrics] [--halls=1] [--menu=PCD] [--queue=fifo|any] [--priority=1] [--serve=SOCKET]\n"
 #define TRUE 1
 #define FALSE 0
+#define MODE_PROCESSES 0
+#define MODE_THREADS 1
+#define MODE_DES 2
+#define ENGINE_ACTORS 0
+#define ENGINE_DES 1
+#define CACHE_LINE 64
+#define CACHE_ALIGNED _Alignas(CACHE_LINE)
+#define QUEUE_FIFO 0
+#define QUEUE_ANY 1
+#define PRIORITY_MAX 4						//priority classes of students at the counter
 /* Macro Constants End */
 
+/* Structs */
+struct Options
+{
+	int log_mode;					//output mode of events, see program-log.h
+	int log_backend;				//how buffered events are written, see program-log.h
+	int run_mode;					//MODE_PROCESSES or MODE_THREADS
+	int engine;						//ENGINE_ACTORS runs real actors, ENGINE_DES simulates them in virtual time
+	int print_stats;				//whether run statistics are printed at the end
+	int shards;						//number of counter shards of S places each
+	int batch;						//plates per supplier delivery and cook trip, -B
+	int kitchen;					//plates the kitchen holds, -K, 0 for 2 * L * M + 1
+	int print_latency;				//whether wait time percentiles are printed at the end
+	char *trace_dir;				//directory of the binary event trace, NULL if not traced
+	int pin_policy;					//placement of actors and segments, see program-pin.h
+	int sync_kind;					//semaphore of the handoffs, see program-sync.h
+	int live_metrics;				//whether the run publishes live metrics for messhall-top
+	int halls;						//independent mess halls run side by side
+	int queue_mode;					//QUEUE_FIFO hands trays out in arrival order, QUEUE_ANY to whoever wakes
+	int classes;					//priority classes of students under QUEUE_FIFO
+	char *serve_path;				//socket of the --serve daemon, NULL for a single run
+};
+/* Structs End */
+
+/* Typdefs */
+typedef struct Options Options;
+/* Typedefs End*/
+
 /* Function Definitions */
 int check_constraint(const int, const int, const int, const int, const int, const int);
-char* handle_options(int, char**, int*, int*, int*, int*, int*);
+const char* handle_options(int, char**, int*, int*, int*, int*, int*, Options*);
 void choose_sent(const int, int*, const int, const int, const int, const int);
-int find_min(const int, const int, const int);
 /* Function Definitions End*/
 
 #endif
@@ -2,63 +2,202 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
-#include <semaphore.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <string.h>
 #include <signal.h>
 #include <sys/mman.h>
 #include <sys/wait.h>
+#include <sys/prctl.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sched.h>
 #include "program-utils.h"
+#include "program-ring.h"
+#include "program-log.h"
+#include "program-input.h"
+#include "program-stats.h"
+#include "program-tables.h"
+#include "program-events.h"
+#include "program-trace.h"
+#include "program-pin.h"
+#include "program-sync.h"
+#include "program-metrics.h"
+#include "program-des.h"
+#include "program-menu.h"
+#include "program-serve.h"
 /* Libraries End*/
 
 /* Macro Constants */
-#define SUPP_COOK "/supplier-cook"
-#define COOK_STUD "/cook-stud"
-#define BLK_SIZE 512
+#define THREAD_STACK_SIZE (256 * 1024)
+#define SPAWN_FANOUT 16						//children forked by one process at startup
+#define KITCHEN_STALL_NS 1000000000LL		//supplier checks for a stalled kitchen this often while blocked
+#define CLAIM_YIELD_ROUNDS 64				//empty sweeps of claim_tray() between two sched_yield()
+#define CLAIM_STALL_NS 1000000000LL			//empty sweeps of claim_tray() this long mean a tray was lost
 /* Macro Constants End*/
 
 /* Shared Memory Structs*/
+/*
+ * Fields written by different actors are kept on separate cache lines: the
+ * supplier owns the ring tails and total_plates, cooks own the ring heads and
+ * course_taken. Data guarded by a shard b_sem shares its line, all of it for
+ * a 3-course menu. Courses are indexed in menu order, see program-menu.c.
+ */
+struct Course_Sem
+{
+	CACHE_ALIGNED Sync_Sem sem;		//plates of one course in the kitchen
+};
 struct Supplier_Cook
 {
-	sem_t b_sem;            		//like a binary semaphore   
-    sem_t empty_sem;        		//empty semaphore 
-    sem_t full_sem;         		//full semaphore
-	sem_t sem_P;					//semaphore for soup
-	sem_t sem_C;					//semaphore for main course
-	sem_t sem_D;					//semaphore for desert
-	int P;                  		//number of soup plates 
-    int C;                  		//number of main course plates
-    int D;                  		//number of desert plates 
-	int total_plates;       		//counter for total plates of food 
-	int total_taken_plates; 		//counter for total taken plates of food 
+    CACHE_ALIGNED Sync_Sem empty_sem;	//empty semaphore 
+	struct Course_Sem course_sem[MENU_MAX];	//semaphore of each course
+	Plate_Ring ring[MENU_MAX];		//ring of the plates of each course
+	CACHE_ALIGNED atomic_int total_plates;       	//counter for total plates of food, written by supplier
+	CACHE_ALIGNED atomic_int course_taken[MENU_MAX];	//plates of each course claimed by cooks, written by cooks
+	CACHE_ALIGNED int slots[];		//slots of the rings, kitchen_stride() for each course
+};
+struct Counter_Shard
+{
+	CACHE_ALIGNED Sync_Sem b_sem;		//like a binary semaphore of this shard
+	int trays;						//complete trays reserved for students, still on this shard
+	int plates[MENU_MAX];			//number of plates of each course
+	atomic_int taken;				//trays taken from this shard by students, read by cooks without the lock
+	CACHE_ALIGNED atomic_int ready;	//reserved trays not claimed by a student yet
+};
+/*
+ * Under --queue=fifo a reserved tray is handed to one student: the cook takes
+ * the oldest waiting student of the first class that has one off the queue and
+ * posts that student's own tray_sem. A tray nobody waits for is counted in
+ * free_trays and taken by the next student to arrive, so free_trays stays 0
+ * while anyone waits. Each class keeps its waiting students in a ring of M.
+ */
+struct Tray_Queue
+{
+	CACHE_ALIGNED Sync_Sem lock_sem;	//like a binary semaphore of the queue
+	int free_trays;					//reserved trays no student waits for
+	int head[PRIORITY_MAX];			//oldest waiting student of each class, index into its ring
+	int waiting[PRIORITY_MAX];		//students of each class waiting for a tray
 };
 struct Cook_Stud
 {
-	sem_t b_sem;            	  	//like a binary semaphore   
-    sem_t full_sem;         	  	//full semaphore
-	sem_t table;					//table place that students eat 
-	int P;                  	  	//number of soup plates 
-    int C;                  	  	//number of main course plates
-    int D;                  	  	//number of desert plates 
-	int number_of_stud;				//number of students at counter
+    CACHE_ALIGNED Sync_Sem full_sem;	//full semaphore, one post per reserved tray of any shard, --queue=any
+	CACHE_ALIGNED atomic_int number_of_stud;	//number of students at counter
+	struct Tray_Queue queue;		//students waiting for a tray, --queue=fifo
+	struct Counter_Shard shard[];			//shards of the counter, S places each, followed by a Cook_Wait per cook,
+											//a Tray_Wait per student and the ring of each class
+};
+struct Cook_Wait
+{
+	CACHE_ALIGNED Sync_Sem wake_sem;	//posted by the supplier or a student while this cook waits for work
+	atomic_int is_waiting;			//set by the cook before it looks for a plate for the last time
+};
+struct Tray_Wait
+{
+	CACHE_ALIGNED Sync_Sem tray_sem;	//posted by the cook that hands this student a tray
+};
+/*
+ * Under --serve the actors are forked once, as a pool of workers sized for the
+ * daemon's parameters. For every job the daemon posts start_sem once per actor
+ * and a worker that takes a post runs the next actor of the job, with the
+ * job's parameters, then goes back to start_sem. The last actor done posts
+ * done_sem. A worker only finishes its actor after all actors arrived at the
+ * start barrier, so no worker runs two actors of one job.
+ */
+struct Worker_Pool
+{
+	CACHE_ALIGNED Sync_Sem start_sem;	//one post per actor of a job, or per worker when the pool closes
+	atomic_int next_actor;			//index of the next actor of the job
+	atomic_int is_closing;			//set before the posts that end the workers
+	Serve_Job job;					//parameters of the current job, K and B filled in
+	CACHE_ALIGNED atomic_int finished;	//actors of the job that are done
+	CACHE_ALIGNED Sync_Sem done_sem;	//posted by the last actor of the job
 };
 /* Shared Memory Structs End */
 
 /* Typdefs */
+typedef struct Course_Sem Course_Sem;
 typedef struct Supplier_Cook Kitchen;
+typedef struct Counter_Shard Counter_Shard;
 typedef struct Cook_Stud Counter;
+typedef struct Tray_Queue Tray_Queue;
+typedef struct Cook_Wait Cook_Wait;
+typedef struct Tray_Wait Tray_Wait;
+typedef struct Worker_Pool Worker_Pool;
 /* Typedefs End*/
 
+/* Layout Checks */
+_Static_assert(offsetof(Kitchen, total_plates) / CACHE_LINE != offsetof(Kitchen, course_taken) / CACHE_LINE,
+			   "supplier and cook counters share a cache line");
+_Static_assert(sizeof(Course_Sem) % CACHE_LINE == 0, "plate semaphores share a cache line");
+_Static_assert(offsetof(Kitchen, slots) % CACHE_LINE == 0, "ring slots are not cache line aligned");
+_Static_assert(offsetof(Counter_Shard, plates) + MENU_FAST * sizeof(int) <= CACHE_LINE,
+			   "shard data of the 3-course menu left the line of its lock");
+_Static_assert(offsetof(Counter_Shard, ready) % CACHE_LINE == 0, "ready trays share the line of the shard lock");
+_Static_assert(sizeof(Counter_Shard) % CACHE_LINE == 0, "neighbouring shards share a cache line");
+_Static_assert(sizeof(Cook_Wait) % CACHE_LINE == 0, "waiting cooks share a cache line");
+_Static_assert(sizeof(Tray_Wait) % CACHE_LINE == 0, "waiting students share a cache line");
+_Static_assert(offsetof(Counter, full_sem) % CACHE_LINE == 0 && offsetof(Counter, number_of_stud) % CACHE_LINE == 0,
+			   "counter semaphore shares a cache line");
+_Static_assert(offsetof(Worker_Pool, finished) / CACHE_LINE != offsetof(Worker_Pool, next_actor) / CACHE_LINE,
+			   "finishing workers share the line of starting ones");
+/* Layout Checks End */
+
 /* Function Declarations */
-int supplier_process(char*);		//process of supplier 
+int supplier_process(Plate_Stream*);		//process of supplier 
 int cook_process(int);				//process of cook
+void publish_plates(int*);			//posts plate semaphores for plates pushed by supplier
+void wait_kitchen_space(void);		//blocks the supplier until the kitchen has a free place
+int kitchen_can_drain(void);		//whether a cook or student can still make room in a full kitchen
+int claim_plate(int*);				//claims a plate of any course that has a place at the counter
+void wake_cooks(void);				//wakes the cooks waiting for a plate they can take
+int place_plates(int, Counter_Shard*, int*, const int);	//places the plates of a cook that go to a shard
+void take_tray(Counter_Shard*);		//takes the plates of a reserved tray off a shard
+int tray_shard(const int);			//shard index that a tray goes to
+int counter_admits(Counter_Shard*, const int);	//whether a shard has a place for the plates of a tray
+void serve_trays(const int);		//hands reserved trays to the waiting students
+void wait_tray(const int);			//blocks a student until a tray is reserved for it
+Counter_Shard *claim_tray(const int);	//claims a ready tray for a student, stealing if needed
+Counter_Shard *counter_shard(const int);	//i-th shard of the counter
+Cook_Wait *cook_wait(const int);	//wait slot of the cook with the given number
+Tray_Wait *tray_wait(const int);	//wait slot of the student with the given number
+int *queue_ring(const int);			//ring of the waiting students of a class
+size_t counter_size(void);			//size of shared memory between cook and student
 int student_process(int);			//process of student
-void init_supp_cook(int*);			//initializes shared memory and semaphores between supplier and cook
-void init_cook_stud(int*);			//initializes shared memory and semaphores between cook and student
-void end_supp_cook(const int);		//destroys shared memory and semaphores between supplier and cook
-void end_cook_stud(const int);		//destroys shared memory and semaphores between cook and student
+void init_supp_cook(void);			//initializes shared memory and semaphores between supplier and cook
+void init_cook_stud(void);			//initializes shared memory and semaphores between cook and student
+void reset_supp_cook(void);			//initializes shared memory between supplier and cook in place
+void reset_cook_stud(void);			//initializes shared memory between cook and student in place
+void end_supp_cook(void);			//destroys shared memory and semaphores between supplier and cook
+void end_cook_stud(void);			//destroys shared memory and semaphores between cook and student
 void handler(int);					//signal handler function
+void *map_segment(const size_t);	//maps memory shared with forked actors, private memory in thread mode
+void unmap_segment(void*, const size_t);	//unmaps memory of map_segment
+int run_hall(Options*, Hall_Result*);	//runs one mess hall in this process, fills its result if given
+int run_halls(Options*);			//forks the halls of --halls and merges their results
+void kill_halls(void);				//interrupts the halls forked so far
+void kitchen_items(int*);			//takes a snapshot of plates of each course at kitchen
+int kitchen_count(void);			//plates at kitchen
+void hall_gauges(long long*, long long*);	//plates at kitchen and students at counter, for the metrics sampler
+size_t kitchen_size(void);			//size of shared memory between supplier and cook
+size_t kitchen_stride(void);		//number of ring slots reserved for each course
+int *kitchen_slots(const int);		//ring slots of a course, in menu order
+Sync_Sem *kitchen_sem(const int);		//plate semaphore of a course
+Plate_Ring *kitchen_ring(const int);	//plate ring of a course
+int run_processes(void);			//runs every actor as a child process
+void spawn_actors(const int, const int, void (*)(const int));	//forks a range of actors through a tree of spawners
+int run_threads(void);				//runs every actor as a thread of this process
+void *actor_thread(void*);			//start routine of an actor thread
+void run_actor(const int);			//runs the i-th actor: supplier, cook or student
+int run_serve(Options*);			//serves jobs from the --serve socket with one pool of workers
+int serve_job(const char*, const Serve_Job*, const long, const int, char*, const size_t);	//runs one job line, formats its reply
+void serve_load(void);				//sets the parameters of the current job of the pool
+const char *serve_wait(void);		//waits for the actors of the current job, NULL or why the pool was replaced
+void spawn_pool(void);				//forks the workers of the pool
+void close_pool(void);				//ends the workers of the pool and reaps them
+void kill_pool(void);				//kills the workers of the pool and reaps them
+void pool_worker(const int);		//runs actors of the jobs until the pool closes
 /* Function Declarations End */
 
 /* Global Variables */
@@ -68,10 +207,25 @@ int T;              				//number of table
 int S;              				//number of counter
 int L;              				//number of times get food from counter
 int K;              				//size of kitchen
+int B;								//number of plates moved per kitchen or counter transaction
+int shard_count;					//number of counter shards
+int tray_places;					//trays a shard admits past the ones taken, S / courses
+int queue_mode;						//whether trays go to students in order, see Tray_Queue
+int classes;						//priority classes of students, student i is in class i % classes
 int process_number;					//total number of process
-pid_t *child_pids;					//holds child process ids
+int run_mode;						//whether actors are processes or threads
+const char *input_name;				//path of plate input
+long long plate_offset;				//plates of each course left to the halls before this one
+long long plate_count = LLONG_MAX;	//plates of each course this hall takes, all for a single hall
+int hall_index = -1;				//hall of this process under --halls, -1 for a single hall
+pid_t *hall_pids;					//processes of the halls, in the parent of --halls only
+int hall_count;						//number of entries of hall_pids
+pid_t actor_group;					//process group of the spawners and actors, 0 when none runs
 Kitchen *kitchen_room; 				//shared memory between supplier-cook
 Counter *counter_room;  			//shared memory between cook-student and student-student
+Table_Set *tables;					//shared memory of the tables between students
+Worker_Pool *pool;					//shared memory between the --serve daemon and its workers
+int pool_size;						//workers of the pool, actors of the largest job
 int counter = 0;
 /* Global Variables End */
 
@@ -79,639 +233,1301 @@ int main(int argc, char *argv[])
 {
 	signal(SIGINT, handler);
 	
-	char *file_name = handle_options(argc, argv, &N, &M, &T, &S, &L);
-
+	Options opts;
+	input_name = handle_options(argc, argv, &N, &M, &T, &S, &L, &opts);
+	K = (opts.kitchen > 0) ? opts.kitchen : 2 * L * M + 1;
     if(!check_constraint(N, M, T, S, L, K))
     {
         exit(EXIT_FAILURE);
     }
 
+	if(opts.serve_path != NULL)
+		return run_serve(&opts);
+	if(opts.halls > 1)
+		return run_halls(&opts);
+	return run_hall(&opts, NULL);
+}
+
+int run_hall(Options *opts, Hall_Result *result)
+{
+	char trace_dir[4096];
+	if(hall_index >= 0 && opts->trace_dir != NULL)
+	{
+		/* halls trace into their own directory, actor numbers repeat between halls */
+		snprintf(trace_dir, sizeof(trace_dir), "%s/hall-%d", opts->trace_dir, hall_index);
+		opts->trace_dir = trace_dir;
+	}
+	log_init(opts->log_mode, opts->log_backend);
+	trace_init(opts->trace_dir);
+	pin_init(opts->pin_policy, N);
+	sync_select(opts->sync_kind);
+	event_set_hall(hall_index);
+	run_mode = (opts->engine == ENGINE_DES) ? MODE_DES : opts->run_mode;
+	B = opts->batch;
+	shard_count = opts->shards;
+	tray_places = S / menu.count;
+	queue_mode = opts->queue_mode;
+	classes = opts->classes;
+
 	process_number = N + M + 1;
-	child_pids = (pid_t*)malloc(process_number);
-	int fd_supp_cook;
-	int fd_cook_stud;
-	init_supp_cook(&fd_supp_cook);
-	init_cook_stud(&fd_cook_stud);
+	if(run_mode != MODE_DES)
+	{
+		init_supp_cook();
+		init_cook_stud();
+		pin_memory(SEGMENT_KITCHEN, kitchen_room, kitchen_size());
+		pin_memory(SEGMENT_COUNTER, counter_room, counter_size());
+	}
+	stats_init((Run_Stats *)map_segment(sizeof(Run_Stats)));
+	tables = (Table_Set *)map_segment(tables_size(T));
+	tables_init(tables, T, run_mode == MODE_PROCESSES);
+	if(opts->live_metrics && run_mode != MODE_DES)
+		metrics_open((hall_index < 0) ? 0 : hall_index, run_mode, N, M, T, S, L, K, process_number);
 
-	for(int i = 0; i < process_number; i++)
+	int exit_code;
+	if(run_mode == MODE_DES)
+		exit_code = des_run(tables, input_name, plate_offset, plate_count, N, M, S, L, K, opts->classes);
+	else
+	{
+		stats_start(process_number, run_mode == MODE_PROCESSES);
+		metrics_start(tables, hall_gauges);
+		exit_code = (run_mode == MODE_THREADS) ? run_threads() : run_processes();
+		run_stats->end_ns = stats_now();
+		metrics_close();
+	}
+	if(opts->print_stats)
+	{
+		stats_print(hall_index, run_mode, N, M, T, S, L, K);
+		tables_print(tables, hall_index, run_stats->end_ns - run_stats->start_ns);
+		if(run_mode != MODE_DES)
+			pin_print();
+	}
+	if(opts->print_latency)
+		stats_print_latency();
+
+	if(run_mode != MODE_DES)
 	{
-        child_pids[i] = fork();
-        if(child_pids[i] == -1)
-        {
+		end_supp_cook();
+		end_cook_stud();
+	}
+	if(result != NULL)
+		stats_hall_result(result);
+	unmap_segment(run_stats, sizeof(Run_Stats));
+	unmap_segment(tables, tables_size(T));
+
+    return exit_code;
+}
+
+int run_halls(Options *opts)
+{
+	/* every hall maps the input and takes its own L * M plates of each course, a stream is spooled into memory once */
+	long long hall_plates = (long long)L * M;
+	input_name = input_spool(input_name, opts->halls * hall_plates);
+	if(input_name == NULL)
+	{
+		char *err_msg = "open(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	trace_init(opts->trace_dir);
+
+	Hall_Result *results = mmap(NULL, opts->halls * sizeof(Hall_Result), PROT_READ | PROT_WRITE,
+								MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	hall_pids = calloc(opts->halls, sizeof(pid_t));
+	if(results == MAP_FAILED || hall_pids == NULL)
+	{
+		char *err_msg = "mmap(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+
+	for(int h = 0; h < opts->halls; h++)
+	{
+		pid_t pid = fork();
+		if(pid == -1)
+		{
 			char *err_msg = "fork(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-            exit(EXIT_FAILURE);
-        }
-        else if(child_pids[i] == 0)
-        {
-            if(i == 0)
-		    {
-				supplier_process(file_name);
-				exit(EXIT_SUCCESS);
-			}
-			else if(i <= N)
-			{
-				cook_process(i);
-				exit(EXIT_SUCCESS);
-			}
-			else
-			{
-				student_process(i%M);
-				exit(EXIT_SUCCESS);
-			}
-        }
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
+			kill_halls();
+			exit(EXIT_FAILURE);
+		}
+		else if(pid == 0)
+		{
+			hall_count = 0;
+			hall_index = h;
+			plate_offset = h * hall_plates;
+			plate_count = hall_plates;
+			pin_hall(h, opts->halls);
+			exit(run_hall(opts, &results[h]));
+		}
+		hall_pids[h] = pid;
+		hall_count = h + 1;
+	}
+
+	int failed = 0;
+	for(int h = 0; h < opts->halls; h++)
+	{
+		int status;
+		while(waitpid(hall_pids[h], &status, 0) == -1 && errno == EINTR);
+		if(!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+			failed++;
+	}
+	hall_count = 0;
+	if(opts->print_stats)
+		stats_print_halls(results, opts->halls, failed);
+
+	munmap(results, opts->halls * sizeof(Hall_Result));
+	free(hall_pids);
+	return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void kill_halls(void)
+{
+	for(int h = 0; h < hall_count; h++)
+		kill(hall_pids[h], SIGINT);
+}
+
+int run_processes(void)
+{
+	/* actors forked by spawners that already exited are reparented here, so waitpid() sees them all */
+	if(prctl(PR_SET_CHILD_SUBREAPER, 1) == -1)
+	{
+		char *err_msg = "prctl(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	actor_group = fork();
+	if(actor_group == -1)
+	{
+		char *err_msg = "fork(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
 	}
+	else if(actor_group == 0)
+	{
+		setpgid(0, 0);
+		spawn_actors(0, process_number, run_actor);
+		exit(EXIT_SUCCESS);
+	}
+	/* both sides set the group, whichever runs first */
+	setpgid(actor_group, actor_group);
 
     int status;
+	int exit_code = EXIT_SUCCESS;
 	pid_t pid;
     do
     {
         pid = waitpid(-1, &status, 0);
+		/* an actor that failed leaves the others blocked forever */
+		if(pid != -1 && exit_code == EXIT_SUCCESS && !(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS))
+		{
+			exit_code = EXIT_FAILURE;
+			kill(-actor_group, SIGKILL);
+		}
     }
 	while (pid != -1);
-	
-	free(child_pids);
-	end_supp_cook(fd_supp_cook);
-	end_cook_stud(fd_cook_stud);
 
-    return 0;
+	actor_group = 0;
+	return exit_code;
 }
 
+void spawn_actors(const int first, const int count, void (*body)(const int))
+{
+	/* up to SPAWN_FANOUT children each, actors when the range is small enough, spawners of sub-ranges otherwise */
+	int step = 1;
+	while(step * SPAWN_FANOUT < count)
+		step *= SPAWN_FANOUT;
+	for(int start = first; start < first + count; start += step)
+	{
+		pid_t pid = fork();
+		if(pid == -1)
+		{
+			char *err_msg = "fork(): unsuccessful!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
+			exit(EXIT_FAILURE);
+		}
+		else if(pid == 0)
+		{
+			if(step == 1)
+				body(start);
+			else
+				spawn_actors(start, (first + count - start < step) ? first + count - start : step, body);
+			exit(EXIT_SUCCESS);
+		}
+	}
+}
 
-int supplier_process(char* input_path)
+int run_threads(void)
 {
-  	int max_plates = 3 * L * M;
-	
-	int fd_input = open(input_path, O_RDONLY);
-	if(fd_input == -1)
+	pthread_t *threads = (pthread_t*)malloc(process_number * sizeof(pthread_t));
+	pthread_attr_t attr;
+	if(threads == NULL || pthread_attr_init(&attr) != 0 || pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE) != 0)
 	{
-		char *err_msg = "open(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
-        exit(EXIT_FAILURE);
+		char *err_msg = "pthread_attr_init(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
 	}
-	
-  	while(kitchen_room->total_plates < max_plates)
-  	{
-  		if(sem_wait(&kitchen_room->b_sem) == -1)
-  		{
-  			char *err_msg = "sem_wait(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
 
-		char plate_type;
-		int read_byte;
-    	if(!((read_byte = read(fd_input, &plate_type, sizeof(char))) == -1) && (errno == EINTR))
-    	{
-			char *err_msg = "read(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-        	exit(EXIT_FAILURE);
-    	}
-
-		char msg[BLK_SIZE];
-        switch (plate_type)
-        {
-        case 'P':
-			sprintf(msg, "The supplier is going to the kitchen to deliver soup: kitchen items P:%d,C:%d,D:%d=%d\n", 
-					kitchen_room->P, 
-                    kitchen_room->C, 
-                    kitchen_room->D, 
-                    (kitchen_room->P + kitchen_room->C + kitchen_room->D));
-            break;
-        case 'C':
-            sprintf(msg, "The supplier is going to the kitchen to deliver main course: kitchen items P:%d,C:%d,D:%d=%d\n", 
-                    kitchen_room->P, 
-                    kitchen_room->C, 
-                    kitchen_room->D, 
-                    (kitchen_room->P + kitchen_room->C + kitchen_room->D));
-            break;
-        case 'D':
-            sprintf(msg, "The supplier is going to the kitchen to deliver desert: kitchen items P:%d,C:%d,D:%d=%d\n", 
-                    kitchen_room->P, 
-                    kitchen_room->C, 
-                    kitchen_room->D, 
-                    (kitchen_room->P + kitchen_room->C + kitchen_room->D));
-            break;
-		default:
-			sprintf(msg, "Invalid plate type!\n");
+	for(int i = 0; i < process_number; i++)
+	{
+		if(pthread_create(&threads[i], &attr, actor_thread, (void*)(intptr_t)i) != 0)
+		{
+			char *err_msg = "pthread_create(): unsuccessful!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
 			exit(EXIT_FAILURE);
-        }
-		write(STDOUT_FILENO, msg, strlen(msg));
+		}
+	}
+	for(int i = 0; i < process_number; i++)
+		pthread_join(threads[i], NULL);
 
-  		if(sem_post(&kitchen_room->b_sem) == -1)
-  		{
-  			char *err_msg = "sem_post(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
-  		if(sem_wait(&kitchen_room->b_sem) == -1)
-  		{
-  			char *err_msg = "sem_wait(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
+	pthread_attr_destroy(&attr);
+	free(threads);
+	return EXIT_SUCCESS;
+}
+
+void *actor_thread(void *arg)
+{
+	run_actor((int)(intptr_t)arg);
+	log_flush();
+	return NULL;
+}
+
+void run_actor(const int i)
+{
+	trace_open(i);
+	pin_actor(i);
+
+	/* the prefetch thread fills its queue while the other actors are still starting */
+	Plate_Stream *stream = NULL;
+	if(i == 0 && (stream = stream_open(input_name, plate_offset, plate_count)) == NULL)
+	{
+		char *err_msg = "open(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	stats_actor_start();
+	metrics_actor(i);
+	if(i == 0)
+		supplier_process(stream);
+	else if(i <= N)
+		cook_process(i);
+	else
+		student_process(i%M);
+	trace_close();
+	metrics_actor_end();
+	stats_actor_end();
+}
+
+int run_serve(Options *opts)
+{
+	/* the daemon's parameters are the capacity, the segments and the pool are sized for them once */
+	signal(SIGTERM, handler);
+	signal(SIGPIPE, SIG_IGN);
+	log_init(opts->log_mode, opts->log_backend);
+	pin_init(PIN_NONE, N);
+	sync_select(opts->sync_kind);
+	run_mode = MODE_PROCESSES;
+	B = opts->batch;
+	shard_count = opts->shards;
+	tray_places = S / menu.count;
+	queue_mode = opts->queue_mode;
+	classes = opts->classes;
+	Serve_Job capacity = {.N = N, .M = M, .T = T, .S = S, .L = L, .K = K, .B = B};
+
+	pool_size = N + M + 1;
+	process_number = pool_size;
+	init_supp_cook();
+	init_cook_stud();
+	stats_init((Run_Stats *)map_segment(sizeof(Run_Stats)));
+	tables = (Table_Set *)map_segment(tables_size(T));
+	pool = (Worker_Pool *)map_segment(sizeof(Worker_Pool));
+	if(prctl(PR_SET_CHILD_SUBREAPER, 1) == -1)
+	{
+		char *err_msg = "prctl(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	int listener = serve_open(opts->serve_path);
+	spawn_pool();
 
-		int post_stat = 0;
-        switch (plate_type)
-        {
-        case 'P':
-            (kitchen_room->P)++;
-  			sprintf(msg, "The supplier delivered soup - after delivery: kitchen items P:%d,C:%d,D:%d=%d\n", 
-                    kitchen_room->P, 
-                    kitchen_room->C, 
-                    kitchen_room->D, 
-                    (kitchen_room->P + kitchen_room->C + kitchen_room->D));
-			post_stat = sem_post(&kitchen_room->sem_P);
-            break;
-        case 'C':
-            (kitchen_room->C)++;
-  			sprintf(msg, "The supplier delivered main course - after delivery: kitchen items P:%d,C:%d,D:%d=%d\n", 
-                    kitchen_room->P, 
-                    kitchen_room->C, 
-                    kitchen_room->D, 
-                    (kitchen_room->P + kitchen_room->C + kitchen_room->D));
-			post_stat = sem_post(&kitchen_room->sem_C);
-            break;
-        default:
-            (kitchen_room->D)++;
-  			sprintf(msg, "The supplier delivered desert - after delivery: kitchen items P:%d,C:%d,D:%d=%d\n", 
-                    kitchen_room->P, 
-                    kitchen_room->C, 
-                    kitchen_room->D, 
-                    (kitchen_room->P + kitchen_room->C + kitchen_room->D));
-			post_stat = sem_post(&kitchen_room->sem_D);
-            break;
-        }
-		write(STDOUT_FILENO, msg, strlen(msg));
-
-  		if(post_stat == -1)
+	char msg[STATS_LINE_SIZE];
+	int len = snprintf(msg, sizeof(msg), "SERVE socket=%s workers=%d N=%d M=%d T=%d K=%d\n", opts->serve_path,
+					   pool_size, N, M, T, K);
+	write(STDERR_FILENO, msg, len);
+
+	long job_id = 0;
+	for(;;)
+	{
+		/* one connection at a time, each may carry any number of jobs */
+		FILE *client = serve_accept(listener);
+		char line[SERVE_LINE_SIZE];
+		while(fgets(line, sizeof(line), client) != NULL)
+		{
+			char *word = line + strspn(line, " \t\r\n");
+			if(*word == '\0')
+				continue;
+			if(strncmp(word, SERVE_QUIT, strlen(SERVE_QUIT)) == 0 &&
+			   word[strlen(SERVE_QUIT) + strspn(word + strlen(SERVE_QUIT), " \t\r\n")] == '\0')
+			{
+				serve_reply(client, "BYE\n", strlen("BYE\n"));
+				fclose(client);
+				close_pool();
+				close(listener);
+				return EXIT_SUCCESS;
+			}
+			char reply[SERVE_LINE_SIZE];
+			len = serve_job(word, &capacity, ++job_id, opts->print_latency, reply, sizeof(reply));
+			if(opts->print_stats)
+				write(STDERR_FILENO, reply, len);
+			if(serve_reply(client, reply, len) == -1)
+				break;
+		}
+		fclose(client);
+	}
+}
+
+int serve_job(const char *line, const Serve_Job *capacity, const long id, const int print_latency, char *reply,
+			  const size_t size)
+{
+	int len = snprintf(reply, size, "JOB id=%ld ", id);
+	Serve_Job job;
+	if(serve_parse(line, &job) == -1)
+		return len + snprintf(reply + len, size - len, "status=invalid reason=syntax\n");
+	if(job.K == 0)
+		job.K = 2 * job.L * job.M + 1;
+	if(job.B == 0)
+		job.B = capacity->B;
+	/* the segments and the pool were sized for the daemon's parameters */
+	if(job.N > capacity->N || job.M > capacity->M || job.T > capacity->T || job.K > capacity->K)
+		return len + snprintf(reply + len, size - len, "status=invalid reason=capacity\n");
+	if(!check_constraint(job.N, job.M, job.T, job.S, job.L, job.K))
+		return len + snprintf(reply + len, size - len, "status=invalid reason=constraint\n");
+	/* an input short of L * M plates of a course would fail the job or leave it blocked */
+	long long counts[MENU_MAX];
+	int input_status = input_count(job.input, (long long)menu.count * job.L * job.M, counts);
+	if(input_status != PLATE_OK && input_status != PLATE_UNCOUNTED)
+		return len + snprintf(reply + len, size - len, "status=invalid reason=input\n");
+	for(int c = 0; c < menu.count && input_status == PLATE_OK; c++)
+		if(counts[c] != (long long)job.L * job.M)
+			return len + snprintf(reply + len, size - len, "status=invalid reason=courses\n");
+
+	/* the segments are reset in place, the workers pick the job up from the pool */
+	pool->job = job;
+	serve_load();
+	reset_supp_cook();
+	reset_cook_stud();
+	stats_init(run_stats);
+	tables_init(tables, T, TRUE);
+	atomic_store(&pool->next_actor, 0);
+	atomic_store(&pool->finished, 0);
+	if(sync_init(&pool->done_sem, TRUE, 0) == -1)
+	{
+		char *err_msg = "sync_init(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	stats_start(process_number, TRUE);
+	for(int i = 0; i < process_number; i++)
+		sync_post(&pool->start_sem);
+	const char *failure = serve_wait();
+	run_stats->end_ns = stats_now();
+
+	if(failure != NULL)
+		return len + snprintf(reply + len, size - len, "status=failed reason=%s\n", failure);
+	len += snprintf(reply + len, size - len, "status=ok ");
+	len += stats_format(reply + len, size - len, run_mode, N, M, T, S, L, K);
+	if(print_latency)
+		stats_print_latency();
+	return len;
+}
+
+void serve_load(void)
+{
+	N = pool->job.N;
+	M = pool->job.M;
+	T = pool->job.T;
+	S = pool->job.S;
+	L = pool->job.L;
+	K = pool->job.K;
+	B = pool->job.B;
+	input_name = pool->job.input;
+	tray_places = S / menu.count;
+	process_number = N + M + 1;
+}
+
+const char *serve_wait(void)
+{
+	/* an actor that failed, or actors that block each other, leave the job blocked forever, the pool is replaced */
+	const char *failure = NULL;
+	long long progress = -1;
+	int idle_checks = 0;				//checks in a row that saw no plate, tray, meal or actor done
+	while(failure == NULL && sync_timedwait(&pool->done_sem, SERVE_CHECK_NS) == -1)
+	{
+		int status;
+		pid_t pid;
+		while(failure == NULL && (pid = waitpid(-1, &status, WNOHANG)) > 0)
 		{
-			char *err_msg = "sem_post(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
+			/* spawners exit once their workers are forked, workers only when they fail */
+			if(!(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS))
+				failure = "actor";
+		}
+		long long now = atomic_load(&run_stats->plates_delivered) + atomic_load(&run_stats->plates_served) +
+						atomic_load(&run_stats->trays_taken) + atomic_load(&run_stats->meals) +
+						atomic_load(&pool->finished);
+		idle_checks = (now == progress) ? idle_checks + 1 : 0;
+		progress = now;
+		if(failure == NULL && idle_checks == SERVE_STALL_CHECKS)
+			failure = "stalled";
+	}
+	if(failure != NULL)
+	{
+		kill_pool();
+		spawn_pool();
+	}
+	return failure;
+}
+
+void spawn_pool(void)
+{
+	atomic_store(&pool->is_closing, FALSE);
+	if(sync_init(&pool->start_sem, TRUE, 0) == -1)
+	{
+		char *err_msg = "sync_init(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	actor_group = fork();
+	if(actor_group == -1)
+	{
+		char *err_msg = "fork(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	else if(actor_group == 0)
+	{
+		setpgid(0, 0);
+		spawn_actors(0, pool_size, pool_worker);
+		exit(EXIT_SUCCESS);
+	}
+	setpgid(actor_group, actor_group);
+}
+
+void close_pool(void)
+{
+	atomic_store(&pool->is_closing, TRUE);
+	for(int i = 0; i < pool_size; i++)
+		sync_post(&pool->start_sem);
+	while(waitpid(-1, NULL, 0) != -1 || errno == EINTR);
+	actor_group = 0;
+}
+
+void kill_pool(void)
+{
+	kill(-actor_group, SIGKILL);
+	while(waitpid(-1, NULL, 0) != -1 || errno == EINTR);
+	actor_group = 0;
+}
+
+void pool_worker(const int worker)
+{
+	(void)worker;
+	for(;;)
+	{
+		if(sync_wait(&pool->start_sem) == -1)
+		{
+			char *err_msg = "sync_wait(): unsuccessful!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
 			exit(EXIT_FAILURE);
 		}
+		if(atomic_load(&pool->is_closing))
+			return;
+		serve_load();
+		run_actor(atomic_fetch_add(&pool->next_actor, 1));
+		log_flush();
+		if(atomic_fetch_add(&pool->finished, 1) + 1 == process_number)
+			sync_post(&pool->done_sem);
+	}
+}
 
-  		(kitchen_room->total_plates)++;
 
-  		if(sem_post(&kitchen_room->b_sem) == -1)
-  		{
-  			char *err_msg = "sem_post(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
-  		if(sem_post(&kitchen_room->full_sem) == -1)
-  		{
-  			char *err_msg = "sem_post(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
+int supplier_process(Plate_Stream *stream)
+{
+  	int max_plates = menu.count * L * M;
+	int course_plates[MENU_MAX] = {0};	//plates of each course delivered
+	
+  	while(atomic_load(&kitchen_room->total_plates) < max_plates)
+  	{
+		/* delivers up to B plates, cooks see them all at once at the end */
+		int delivered = atomic_load(&kitchen_room->total_plates);
+		int batch = (max_plates - delivered < B) ? max_plates - delivered : B;
+		int posts[MENU_MAX] = {0};
+		for(int i = 0; i < batch; i++)
+		{
+			int course;
+			int status = stream_next(stream, &course);
+    		if(status == PLATE_END)
+    		{
+				char *err_msg = "Not enough plates in the input!\n";
+				write(STDERR_FILENO, err_msg, strlen(err_msg));
+        		exit(EXIT_FAILURE);
+    		}
+			if(status == PLATE_INVALID)
+			{
+				char *err_msg = "Invalid plate type!\n";
+				write(STDERR_FILENO, err_msg, strlen(err_msg));
+				exit(EXIT_FAILURE);
+			}
+			/* the k-th plate of a course goes on tray k, a course past L * M leaves another one short forever */
+			if(++course_plates[course] > L * M)
+			{
+				char *err_msg = "The input does not hold L*M plates of every course, trays cannot be completed!\n";
+				write(STDERR_FILENO, err_msg, strlen(err_msg));
+				exit(EXIT_FAILURE);
+			}
+			int items[MENU_MAX];
+			kitchen_items(items);
+			event_supplier_going(course, items);
+
+			/* blocks only when the kitchen is full, cooks must see the batch first */
+			if(stats_trywait(&kitchen_room->empty_sem, WAIT_SUPPLIER_EMPTY) == -1)
+			{
+				publish_plates(posts);
+				wait_kitchen_space();
+			}
+
+			int plate_no = delivered + i;
+			int push_stat = ring_push(kitchen_ring(course), kitchen_slots(course), plate_no);
+			posts[course]++;
+			if(!push_stat)
+			{
+				char *err_msg = "ring_push(): kitchen is full!\n";
+				write(STDERR_FILENO, err_msg, strlen(err_msg));
+				exit(EXIT_FAILURE);
+			}
+
+			kitchen_items(items);
+			event_supplier_delivered(course, items);
+		}
+  		atomic_fetch_add(&kitchen_room->total_plates, batch);
+		stats_access(SEGMENT_KITCHEN);
+		atomic_fetch_add_explicit(&run_stats->plates_delivered, batch, memory_order_relaxed);
+		metrics_progress(batch);
+
+		publish_plates(posts);
   	}
-	close(fd_input);
-	char *goodbye = "The supplier finished supplying - GOODBYE!\n";
-	write(STDOUT_FILENO, goodbye, strlen(goodbye));
+	stream_close(stream);
+	event_supplier_done();
 
 	return 0;
 }
 
-int cook_process(int number)
+MENU_INLINE int place_plates_courses(const int courses, int number, Counter_Shard *shard, int *plates, const int batch)
 {
-	int is_break = FALSE;
-	int plate_type = 1;
-  	int max_plates = 3 * L * M;
+  	if (stats_wait(&shard->b_sem, WAIT_COOK_COUNTER) == -1)
+  	{
+  		char *err_msg = "sync_wait(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+  		exit(EXIT_FAILURE);
+  	}
 
-  	while(kitchen_room->total_plates < max_plates || (kitchen_room->P + kitchen_room->C + kitchen_room->D) > 0)
+	int placed = 0;
+	for(int i = 0; i < batch; i++)
+	{
+		if(plates[i] < 0 || counter_shard(tray_shard(plates[i] / courses)) != shard)
+			continue;
+		int course = plates[i] % courses;
+		event_cook_going(number, course, shard->plates);
+		(shard->plates[course])++;
+		event_cook_placed(number, course, shard->plates);
+		plates[i] = -1;
+		placed++;
+	}
+
+	/* reserves every tray completed on this shard while holding its lock, the course with fewest plates limits them */
+	int complete = shard->plates[0];
+	for(int course = 1; course < courses; course++)
+		complete = (shard->plates[course] < complete) ? shard->plates[course] : complete;
+	int new_trays = complete - shard->trays;
+	shard->trays = complete;
+	/* ready is raised before serve_trays() hands the trays out, claim_tray() relies on it */
+	atomic_fetch_add(&shard->ready, new_trays);
+
+  	if(sync_post(&shard->b_sem) == -1)
   	{
-  		if(sem_wait(&kitchen_room->b_sem) == -1)
-  		{
-  			char *err_msg = "sem_wait(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
+  		char *err_msg = "sync_post(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+  		exit(EXIT_FAILURE);
+  	}
+	atomic_fetch_add_explicit(&run_stats->plates_served, placed, memory_order_relaxed);
+	metrics_progress(placed);
+	stats_access(SEGMENT_COUNTER);
 
-  		(kitchen_room->total_taken_plates)++;
-		char msg[BLK_SIZE];
-  	
-  		if(kitchen_room->total_taken_plates <= max_plates)
-  		{
-  			sprintf(msg, "Cook %d going to the kitchen to wait for/get a plate - kitchen items P:%d,C:%d,D:%d=%d\n", 
-			  		number, 
-					kitchen_room->P, 
-					kitchen_room->C, 
-					kitchen_room->D, 
-					(kitchen_room->P + kitchen_room->C + kitchen_room->D));
-			write(STDOUT_FILENO, msg, strlen(msg));
-  			plate_type = ((kitchen_room->total_taken_plates - 1) % 3) + 1;
-  		}
-		else
-		{
-  			(kitchen_room->total_taken_plates)--;
-  			is_break = TRUE;
- 		}
+	serve_trays(new_trays);
+	return placed;
+}
 
-  		if(sem_post(&kitchen_room->b_sem) == -1)
-  		{
-  			char *err_msg = "sem_post(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
+int place_plates(int number, Counter_Shard *shard, int *plates, const int batch)
+{
+	return MENU_SPECIALIZE(place_plates_courses, number, shard, plates, batch);
+}
+
+MENU_INLINE void take_tray_courses(const int courses, Counter_Shard *shard)
+{
+	for(int course = 0; course < courses; course++)
+		(shard->plates[course])--;
+	(shard->trays)--;
+	atomic_fetch_add(&shard->taken, 1);
+}
+
+void take_tray(Counter_Shard *shard)
+{
+	MENU_SPECIALIZE(take_tray_courses, shard);
+}
 
-  		if(is_break)
+int tray_shard(const int tray)
+{
+	/* the plates of a tray go to the same shard, trays round robin */
+	return tray % shard_count;
+}
+
+int counter_admits(Counter_Shard *shard, const int tray)
+{
+	/* trays of a shard get places in claim order, S / courses trays past the taken ones */
+	return tray / shard_count < atomic_load(&shard->taken) + tray_places;
+}
+
+void serve_trays(const int trays)
+{
+	/*
+	 * The trays were already added to the ready count of their shard, so every
+	 * post below and every free tray stands for a ready tray: a student handed
+	 * one finds it in claim_tray(), at worst after a racing student took the
+	 * one on its own shard.
+	 */
+	if(queue_mode == QUEUE_ANY)
+	{
+		/* one post per reserved tray wakes exactly one student */
+		for(int i = 0; i < trays; i++)
 		{
+			if(sync_post(&counter_room->full_sem) == -1)
+			{	
+				char *err_msg = "sync_post(): unsuccessful!\n";
+				write(STDERR_FILENO, err_msg, strlen(err_msg));
+				exit(EXIT_FAILURE);
+			}
+		}
+		return;
+	}
+	if(trays == 0)
+		return;
+
+	Tray_Queue *queue = &counter_room->queue;
+	int served[trays];
+	int count = 0;
+	if(stats_wait(&queue->lock_sem, WAIT_COOK_QUEUE) == -1)
+	{
+		char *err_msg = "sync_wait(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	for(; count < trays; count++)
+	{
+		int class = 0;
+		while(class < classes && queue->waiting[class] == 0)
+			class++;
+		if(class == classes)
 			break;
-		} 
+		served[count] = queue_ring(class)[queue->head[class]];
+		queue->head[class] = (queue->head[class] + 1) % M;
+		queue->waiting[class]--;
+	}
+	queue->free_trays += trays - count;
+	if(sync_post(&queue->lock_sem) == -1)
+	{
+		char *err_msg = "sync_post(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
 
-		int wait_stat = 0;
-		switch (plate_type)
+	/* woken outside the lock, the student does not have to wait for it again */
+	for(int i = 0; i < count; i++)
+	{
+		if(sync_post(&tray_wait(served[i])->tray_sem) == -1)
 		{
-		case 1:
-			wait_stat = sem_wait(&kitchen_room->sem_P);
-			break;
-		case 2:
-			wait_stat = sem_wait(&kitchen_room->sem_C);
-			break;
-		case 3:
-			wait_stat = sem_wait(&kitchen_room->sem_D);
-			break;
-		default:
-			break;
+			char *err_msg = "sync_post(): unsuccessful!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
+			exit(EXIT_FAILURE);
 		}
-  		
-		if (wait_stat == -1)
+	}
+}
+
+void wait_tray(const int number)
+{
+	if(queue_mode == QUEUE_ANY)
+	{
+		if(stats_wait(&counter_room->full_sem, WAIT_STUDENT_TRAY) == -1)
 		{
-			char *err_msg = "sem_wait(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-	  		exit(EXIT_FAILURE);
+			char *err_msg = "sync_wait(): unsuccessful!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
+			exit(EXIT_FAILURE);
 		}
-		if (sem_wait(&kitchen_room->full_sem) == -1)
+		return;
+	}
+
+	Tray_Queue *queue = &counter_room->queue;
+	if(stats_wait(&queue->lock_sem, WAIT_STUDENT_QUEUE) == -1)
+	{
+		char *err_msg = "sync_wait(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	int is_free = (queue->free_trays > 0);
+	if(is_free)
+		queue->free_trays--;
+	else
+	{
+		int class = number % classes;
+		queue_ring(class)[(queue->head[class] + queue->waiting[class]) % M] = number;
+		queue->waiting[class]++;
+	}
+	if(sync_post(&queue->lock_sem) == -1)
+	{
+		char *err_msg = "sync_post(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+
+	if(is_free)
+		stats_record(WAIT_STUDENT_TRAY, 0);
+	else if(stats_wait(&tray_wait(number)->tray_sem, WAIT_STUDENT_TRAY) == -1)
+	{
+		char *err_msg = "sync_wait(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+}
+
+Counter_Shard *claim_tray(const int number)
+{
+	/* a tray handed out guarantees a ready one exists, see serve_trays(), home shard first then stealing */
+	long long empty_since = 0;
+	for(int round = 1; ; round++)
+	{
+		for(int k = 0; k < shard_count; k++)
 		{
-			char *err_msg = "sem_wait(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-			exit(EXIT_FAILURE);
+			Counter_Shard *shard = counter_shard((number + k) % shard_count);
+			int ready = atomic_load(&shard->ready);
+			while(ready > 0)
+			{
+				if(atomic_compare_exchange_weak(&shard->ready, &ready, ready - 1))
+					return shard;
+			}
 		}
-  		if (sem_wait(&kitchen_room->b_sem) == -1)
-  		{
-  			char *err_msg = "sem_wait(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
-  		if (sem_wait(&counter_room->b_sem) == -1)
-  		{
-  			char *err_msg = "sem_wait(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
 
-		switch (plate_type)
+		/* a sweep only comes up empty while others race for the same trays, a long run of them is a lost tray */
+		cpu_relax();
+		if(round % CLAIM_YIELD_ROUNDS == 0)
 		{
-		case 1:
-  			(kitchen_room->P)--;
-  			sprintf(msg, "Cook %d is going to the counter to deliver soup – counter items P:%d,C:%d,D:%d=%d\n", 
-			  		number, 
-					counter_room->P, 
-					counter_room->C, 
-					counter_room->D, 
-					(counter_room->P + counter_room->C + counter_room->D));		
-			break;
-		case 2:
-			(kitchen_room->C)--;
-  			sprintf(msg, "Cook %d is going to the counter to deliver main course – counter items P:%d,C:%d,D:%d=%d\n", 
-			  		number, 
-					counter_room->P, 
-					counter_room->C, 
-					counter_room->D, 
-					(counter_room->P + counter_room->C + counter_room->D));
-			break;
-		case 3:
-			(kitchen_room->D)--;
-  			sprintf(msg, "Cook %d is going to the counter to deliver desert – counter items P:%d,C:%d,D:%d=%d\n", 
-			  		number, 
-					counter_room->P, 
-					counter_room->C, 
-					counter_room->D, 
-					(counter_room->P + counter_room->C + counter_room->D));
-			break;
-		default:
-			break;
+			sched_yield();
+			if(empty_since == 0)
+				empty_since = stats_now();
+			else if(stats_now() - empty_since > CLAIM_STALL_NS)
+			{
+				char *err_msg = "claim_tray(): a student was handed a tray that is not ready!\n";
+				write(STDERR_FILENO, err_msg, strlen(err_msg));
+				exit(EXIT_FAILURE);
+			}
 		}
-		write(STDOUT_FILENO, msg, strlen(msg));
+	}
+}
 
-  		if(sem_post(&counter_room->b_sem) == -1)
-  		{
-  			char *err_msg = "sem_post(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}	
+MENU_INLINE void publish_plates_courses(const int courses, int *posts)
+{
+	int post_stat = 0;
+	int is_posted = FALSE;
+	for(int course = 0; course < courses; course++)
+	{
+		is_posted = is_posted || (posts[course] > 0);
+		for(; posts[course] > 0 && post_stat != -1; posts[course]--)
+			post_stat = sync_post(kitchen_sem(course));
+	}
+  	if(post_stat == -1)
+	{
+		char *err_msg = "sync_post(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	if(is_posted)
+		wake_cooks();
+}
 
-  		if(sem_post(&kitchen_room->b_sem) == -1)
-  		{
-  			char *err_msg = "sem_post(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
+void publish_plates(int *posts)
+{
+	MENU_SPECIALIZE(publish_plates_courses, posts);
+}
 
-  		if(sem_post(&kitchen_room->empty_sem) == -1)
+void wait_kitchen_space(void)
+{
+	/* waits in slices, a full kitchen with no progress and nothing to take never drains */
+	long long begin = stats_now();
+	long progress = -1;
+	while(sync_timedwait(&kitchen_room->empty_sem, KITCHEN_STALL_NS) == -1)
+	{
+		if(errno != ETIMEDOUT)
+		{
+			char *err_msg = "sync_timedwait(): unsuccessful!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
+			exit(EXIT_FAILURE);
+		}
+		long now = atomic_load(&run_stats->plates_served) + atomic_load(&run_stats->trays_taken);
+		if(now == progress && !kitchen_can_drain())
 		{
-			char *err_msg = "sem_post(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
+			/* the STATS line of the failed run still shows this wait */
+			stats_record(WAIT_SUPPLIER_EMPTY, stats_now() - begin);
+			stats_actor_end();
+			char *err_msg = "The kitchen is full of plates the counter cannot take, the input needs a larger -K!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
 			exit(EXIT_FAILURE);
 		}
+		progress = now;
+	}
+	stats_record(WAIT_SUPPLIER_EMPTY, stats_now() - begin);
+}
 
-  		if(sem_wait(&counter_room->b_sem) == -1)
-  		{
-  			char *err_msg = "sem_wait(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
-  		
-  		if(plate_type == 1)
-  		{
-  			(counter_room->P)++;
-  			sprintf(msg, "Cook %d placed soup on the counter - counter items P:%d,C:%d,D:%d=%d\n", 
-			  		number, 
-					counter_room->P, 
-					counter_room->C, 
-					counter_room->D, 
-					(counter_room->P + counter_room->C + counter_room->D));
-  		}
-  		else if(plate_type == 2)
-  		{
-  			(counter_room->C)++;
-  			sprintf(msg, "Cook %d placed main course on the counter - counter items P:%d,C:%d,D:%d=%d\n", 
-			  		number, 
-					counter_room->P, 
-					counter_room->C, 
-					counter_room->D, 
-					(counter_room->P + counter_room->C + counter_room->D));
-  		}
-  		else
-  		{
-  			(counter_room->D)++;
-  			sprintf(msg, "Cook %d placed desert on the counter - counter items P:%d,C:%d,D:%d=%d\n", 
-			  		number, 
-					counter_room->P, 
-					counter_room->C, 
-					counter_room->D, 
-					(counter_room->P + counter_room->C + counter_room->D));
-  		}
-		write(STDOUT_FILENO, msg, strlen(msg));
+int kitchen_can_drain(void)
+{
+	for(int course = 0; course < menu.count; course++)
+	{
+		int taken = atomic_load(&kitchen_room->course_taken[course]);
+		if(ring_count(kitchen_ring(course)) > 0 && taken < L * M && counter_admits(counter_shard(tray_shard(taken)), taken))
+			return TRUE;
+	}
+	for(int i = 0; i < shard_count; i++)
+		if(atomic_load(&counter_shard(i)->ready) > 0)
+			return TRUE;
+	return FALSE;
+}
 
-  		if(sem_post(&counter_room->b_sem) == -1)
-  		{
-  			char *err_msg = "sem_post(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
+MENU_INLINE int claim_plate_courses(const int courses, int *is_done)
+{
+	/* the course claimed least so far goes first, it holds the next trays back */
+	int order[MENU_MAX];
+	int claimed[MENU_MAX];
+	for(int c = 0; c < courses; c++)
+	{
+		order[c] = c;
+		claimed[c] = atomic_load(&kitchen_room->course_taken[c]);
+	}
+	for(int i = 1; i < courses; i++)
+		for(int j = i; j > 0 && claimed[order[j]] < claimed[order[j - 1]]; j--)
+		{
+			int tmp = order[j];
+			order[j] = order[j - 1];
+			order[j - 1] = tmp;
+		}
 
-  		if (((counter_room->P > 0) && (counter_room->C > 0) && (counter_room->D > 0)))
+	*is_done = TRUE;
+	for(int i = 0; i < courses; i++)
+	{
+		int course = order[i];
+		int taken = claimed[course];
+		while(taken < L * M)
 		{
-			int sem_val;
-			sem_getvalue(&counter_room->full_sem, &sem_val);
-			if(sem_val < find_min(counter_room->P, counter_room->D, counter_room->D))
+			/* the k-th plate of a course belongs to tray k, it is claimed only once that tray has a place */
+			*is_done = FALSE;
+			int plate = taken * courses + course;
+			if(!counter_admits(counter_shard(tray_shard(taken)), taken) || sync_trywait(kitchen_sem(course)) == -1)
+				break;
+			if(!atomic_compare_exchange_strong(&kitchen_room->course_taken[course], &taken, taken + 1))
 			{
-				if(sem_post(&counter_room->full_sem) == -1)
-				{	
-					char *err_msg = "sem_post(): unsuccessful!\n";
-					write(STDERR_FILENO, err_msg, sizeof(err_msg));
+				if(sync_post(kitchen_sem(course)) == -1)
+				{
+					char *err_msg = "sync_post(): unsuccessful!\n";
+					write(STDERR_FILENO, err_msg, strlen(err_msg));
 					exit(EXIT_FAILURE);
 				}
+				continue;
 			}
+
+			int plate_no;
+			if(!ring_pop(kitchen_ring(course), kitchen_slots(course), &plate_no))
+			{
+				char *err_msg = "ring_pop(): kitchen is empty!\n";
+				write(STDERR_FILENO, err_msg, strlen(err_msg));
+				exit(EXIT_FAILURE);
+			}
+  			if(sync_post(&kitchen_room->empty_sem) == -1)
+			{
+				char *err_msg = "sync_post(): unsuccessful!\n";
+				write(STDERR_FILENO, err_msg, strlen(err_msg));
+				exit(EXIT_FAILURE);
+			}
+			stats_access(SEGMENT_KITCHEN);
+			return plate;
 		}
-		  
+	}
+	return -1;
+}
+
+int claim_plate(int *is_done)
+{
+	return MENU_SPECIALIZE(claim_plate_courses, is_done);
+}
+
+void wake_cooks(void)
+{
+	for(int i = 1; i <= N; i++)
+	{
+		Cook_Wait *wait = cook_wait(i);
+		if(atomic_load(&wait->is_waiting) && atomic_exchange(&wait->is_waiting, FALSE) && sync_post(&wait->wake_sem) == -1)
+		{
+			char *err_msg = "sync_post(): unsuccessful!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+int cook_process(int number)
+{
+	int plates[B];
+	int is_done = FALSE;
+	int is_waiting = FALSE;
+  	while(!is_done)
+  	{
+		/* takes up to B plates of whatever course can go to the counter, never sleeps holding one */
+		int batch = 0;
+		int is_looking = FALSE;
+		while(batch < B)
+		{
+			if(!is_looking)
+			{
+				int items[MENU_MAX];
+				kitchen_items(items);
+				event_cook_kitchen(number, items);
+				is_looking = TRUE;
+			}
+			int plate = claim_plate(&is_done);
+			if(plate >= 0)
+			{
+				plates[batch++] = plate;
+				is_looking = FALSE;
+				continue;
+			}
+			if(is_done || batch > 0)
+				break;
+
+			if(!is_waiting)
+			{
+				/* registers before looking once more, a plate or tray arriving meanwhile still wakes us */
+				atomic_store(&cook_wait(number)->is_waiting, TRUE);
+				is_waiting = TRUE;
+			}
+			else
+			{
+				if(stats_wait(&cook_wait(number)->wake_sem, WAIT_COOK_PLATE) == -1)
+				{
+					char *err_msg = "sync_wait(): unsuccessful!\n";
+					write(STDERR_FILENO, err_msg, strlen(err_msg));
+					exit(EXIT_FAILURE);
+				}
+				is_waiting = FALSE;
+			}
+		}
+
+		/* every claimed plate has a place, one lock per shard delivers them */
+		for(int i = 0; i < batch; i++)
+			if(plates[i] >= 0)
+				place_plates(number, counter_shard(tray_shard(plates[i] / menu.count)), plates, batch);
   	}
-	char goodbye[BLK_SIZE];
-  	sprintf(goodbye, "Cook %d finished serving - items at kitchen: %d - going home - GOODBYE!!!\n", 
-	  		number, 
-			(kitchen_room->P + kitchen_room->C + kitchen_room->D));
-	write(STDOUT_FILENO, goodbye, strlen(goodbye));
+	/* the cooks still waiting see that every plate is claimed */
+	wake_cooks();
+
+	event_cook_done(number, kitchen_count());
 	return 0;
 }
 
 int student_process(int number)
 {
 	int total_eat = 0;
-	char msg[BLK_SIZE];
+	Counter_Shard *home = counter_shard(number % shard_count);
 	while(total_eat < L)
 	{
 		total_eat++;
-  		if(sem_wait(&counter_room->b_sem) == -1)
-  		{
-  			char *err_msg = "sem_wait(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
-		(counter_room->number_of_stud)++;
-		sprintf(msg, "Student %d is going to the counter (round %d) - # of students at counter: %d and counter items P:%d,C:%d,D:%d=%d\n",
-				number,
-				total_eat,
-				counter_room->number_of_stud,
-				counter_room->P,
-				counter_room->C,
-				counter_room->D,
-				(counter_room->P + counter_room->C + counter_room->D));
-		write(STDOUT_FILENO, msg, strlen(msg));
-		if(sem_post(&counter_room->b_sem) == -1)
-  		{
-  			char *err_msg = "sem_post(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
+		long long arrived = stats_now();
+		int at_counter = atomic_fetch_add(&counter_room->number_of_stud, 1) + 1;
+		if(log_enabled())
+		{
+			/* the lock is only needed for a consistent snapshot in the message */
+  			if(stats_wait(&home->b_sem, WAIT_STUDENT_COUNTER) == -1)
+  			{
+  				char *err_msg = "sync_wait(): unsuccessful!\n";
+				write(STDERR_FILENO, err_msg, strlen(err_msg));
+  				exit(EXIT_FAILURE);
+  			}
+			event_student_counter(number, total_eat, at_counter, home->plates);
+			if(sync_post(&home->b_sem) == -1)
+  			{
+  				char *err_msg = "sync_post(): unsuccessful!\n";
+				write(STDERR_FILENO, err_msg, strlen(err_msg));
+  				exit(EXIT_FAILURE);
+  			}
+		}
 
-		if(sem_wait(&counter_room->full_sem) == -1)
-  		{
-  			char *err_msg = "sem_wait(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  			exit(EXIT_FAILURE);
-  		}
-		(counter_room->P)--;
-		(counter_room->C)--;
-		(counter_room->D)--;
-		if(sem_wait(&counter_room->b_sem) == -1)
+		wait_tray(number);
+		Counter_Shard *shard = claim_tray(number);
+		if(stats_wait(&shard->b_sem, WAIT_STUDENT_COUNTER) == -1)
   		{
-  			char *err_msg = "sem_wait(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
+  			char *err_msg = "sync_wait(): unsuccessful!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
   			exit(EXIT_FAILURE);
   		}
+		/* the claimed tray was reserved by a cook, take it */
+		take_tray(shard);
+		stats_span(WAIT_STUDENT_SERVED + number % classes, stats_now() - arrived);
 
-		sprintf(msg, "Student %d got food and is going to get a table (round %d) - # of empty tables: %d\n",
-				number,
-				total_eat,
-				0);
-		write(STDOUT_FILENO, msg, strlen(msg));
-		(counter_room->number_of_stud)--;
-		if(sem_post(&counter_room->b_sem) == -1)
+		atomic_fetch_add_explicit(&run_stats->trays_taken, 1, memory_order_relaxed);
+		stats_access(SEGMENT_COUNTER);
+		event_student_got(number, total_eat, tables_empty(tables));
+		atomic_fetch_sub(&counter_room->number_of_stud, 1);
+		if(sync_post(&shard->b_sem) == -1)
   		{
-  			char *err_msg = "sem_post(): unsuccessful!\n";
-			write(STDERR_FILENO, err_msg, sizeof(err_msg));
+  			char *err_msg = "sync_post(): unsuccessful!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
   			exit(EXIT_FAILURE);
   		}
+
+		/* a tray left the shard, cooks waiting for a place look again */
+		wake_cooks();
 		
-		if(sem_wait(&counter_room->table) == -1)
-  		{
-  			perror("sem_wait");
-  			exit(EXIT_FAILURE);
-  		}
-		int table_val;
-		sem_getvalue(&counter_room->table, &table_val);
-		sprintf(msg, "Student %d sat at table %d to eat (round %d) - empty tables: %d\n", number, table_val, total_eat, T - table_val);
-		write(STDOUT_FILENO, msg, strlen(msg));
-		if(table_val < T)
-		{
-			if(sem_post(&counter_room->table) == -1)
-			{
-				char *err_msg = "sem_post(): unsuccessful!\n";
-				write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  				exit(EXIT_FAILURE);
-			}
-			if(total_eat < L)
-			{
-				int table_val;
-				sem_getvalue(&counter_room->table, &table_val);
-				sprintf(msg, "Student %d left table %d to eat again (round %d) - empty tables:%d\n", number, table_val - 1, total_eat, table_val);
-				write(STDOUT_FILENO, msg, strlen(msg));
-			}
-		}
+		int table = table_acquire(tables, number);
+		event_student_sat(number, table, total_eat, tables_empty(tables));
+		atomic_fetch_add_explicit(&run_stats->meals, 1, memory_order_relaxed);
+		metrics_progress(1);
+		table_release(tables, table);
+		if(total_eat < L)
+			event_student_left(number, table, total_eat, tables_empty(tables));
 	}
-	sprintf(msg, "Student %d is done eating %d times - going home - GOODBYE!!!\n", number, total_eat);
-	write(STDOUT_FILENO, msg, strlen(msg));
+	event_student_done(number, total_eat);
 	return 0;
 }
 
-void init_supp_cook(int* fd_supp_cook)
+void init_supp_cook(void)
 {
-	*fd_supp_cook = shm_open(SUPP_COOK, O_CREAT | O_RDWR, 0666);
-	if (*fd_supp_cook < 0)
-	{
-		char *err_msg = "shm_open(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
-		exit(EXIT_FAILURE);
-	}
-
-	if(ftruncate(*fd_supp_cook, sizeof(Kitchen)) == -1)
-	{
-	    char *err_msg = "ftruncate(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
-	    exit(EXIT_FAILURE);
-  	}
+	kitchen_room = (Kitchen *)map_segment(kitchen_size());
+	reset_supp_cook();
+}
 
-	kitchen_room = (Kitchen *)mmap(NULL, sizeof(Kitchen), PROT_READ | PROT_WRITE, MAP_SHARED, *fd_supp_cook, 0);
-    if(kitchen_room == MAP_FAILED)
+void reset_supp_cook(void)
+{
+	int pshared = (run_mode == MODE_PROCESSES);
+	atomic_init(&kitchen_room->total_plates, 0);
+	int init_stat = sync_init(&kitchen_room->empty_sem, pshared, K);
+	for(int c = 0; c < menu.count; c++)
 	{
-		char *err_msg = "mmap(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
-		exit(EXIT_FAILURE);
+		ring_init(kitchen_ring(c), K);
+		atomic_init(&kitchen_room->course_taken[c], 0);
+		if(init_stat != -1)
+			init_stat = sync_init(kitchen_sem(c), pshared, 0);
 	}
-    K = 2 * L * M + 1;
-	kitchen_room->P = 0;
-	kitchen_room->C = 0;
-	kitchen_room->D = 0;
-	kitchen_room->total_plates = 0;
-	kitchen_room->total_taken_plates = 0;
-	if((sem_init(&kitchen_room->b_sem, 1, 1) == -1) || 
-       (sem_init(&kitchen_room->empty_sem, 1, K) == -1) || 
-       (sem_init(&kitchen_room->full_sem, 1, 0) == -1) || 
-	   (sem_init(&kitchen_room->sem_P, 1, 0) == -1) || 
-	   (sem_init(&kitchen_room->sem_C, 1, 0) == -1) || 
-	   (sem_init(&kitchen_room->sem_D, 1, 0) == -1))
-	{
-		char *err_msg = "sem_init(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
+	if(init_stat == -1)
+	{
+		char *err_msg = "sync_init(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
 		exit(EXIT_FAILURE);
 	}
 }
 
-void init_cook_stud(int *fd)
+void init_cook_stud(void)
+{
+	counter_room = (Counter *)map_segment(counter_size());
+	reset_cook_stud();
+}
+
+void reset_cook_stud(void)
 {
-	*fd = shm_open(COOK_STUD, O_CREAT | O_RDWR, 0666);
-	if (*fd < 0)
+	int pshared = (run_mode == MODE_PROCESSES);
+	atomic_init(&counter_room->number_of_stud, 0);
+	if(sync_init(&counter_room->full_sem, pshared, 0) == -1)
 	{
-		char *err_msg = "shm_open(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
+		char *err_msg = "sync_init(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
 		exit(EXIT_FAILURE);
 	}
-
-	if(ftruncate(*fd, sizeof(Counter)) == -1)
+	Tray_Queue *queue = &counter_room->queue;
+	queue->free_trays = 0;
+	for(int c = 0; c < PRIORITY_MAX; c++)
 	{
-	    char *err_msg = "ftruncate(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
-	    exit(EXIT_FAILURE);
-  	}
-
-	counter_room = (Counter *)mmap(NULL, sizeof(Counter), PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
-    if(counter_room == MAP_FAILED)
+		queue->head[c] = 0;
+		queue->waiting[c] = 0;
+	}
+	if(sync_init(&queue->lock_sem, pshared, 1) == -1)
 	{
-		char *err_msg = "mmap(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
+		char *err_msg = "sync_init(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
 		exit(EXIT_FAILURE);
 	}
-	counter_room->P = 0;
-	counter_room->C = 0;
-	counter_room->D = 0;
-	counter_room->number_of_stud = 0;
-	if((sem_init(&counter_room->b_sem, 1, 1) == -1) ||  
-       (sem_init(&counter_room->full_sem, 1, 0) == -1) ||
-	   (sem_init(&counter_room->table, 1, T)))
+	for(int i = 0; i < shard_count; i++)
 	{
-		char *err_msg = "sem_init(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
-		exit(EXIT_FAILURE);
+		Counter_Shard *shard = counter_shard(i);
+		for(int c = 0; c < menu.count; c++)
+			shard->plates[c] = 0;
+		shard->trays = 0;
+		atomic_init(&shard->taken, 0);
+		atomic_init(&shard->ready, 0);
+		if(sync_init(&shard->b_sem, pshared, 1) == -1)
+		{
+			char *err_msg = "sync_init(): unsuccessful!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
+			exit(EXIT_FAILURE);
+		}
+	}
+	for(int i = 1; i <= N; i++)
+	{
+		atomic_init(&cook_wait(i)->is_waiting, FALSE);
+		if(sync_init(&cook_wait(i)->wake_sem, pshared, 0) == -1)
+		{
+			char *err_msg = "sync_init(): unsuccessful!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
+			exit(EXIT_FAILURE);
+		}
+	}
+	for(int i = 0; i < M; i++)
+	{
+		if(sync_init(&tray_wait(i)->tray_sem, pshared, 0) == -1)
+		{
+			char *err_msg = "sync_init(): unsuccessful!\n";
+			write(STDERR_FILENO, err_msg, strlen(err_msg));
+			exit(EXIT_FAILURE);
+		}
 	}
 }
 
-void end_supp_cook(const int fd_supp_cook)
+void end_supp_cook(void)
 {
-	if(munmap(kitchen_room, sizeof(Kitchen)) == -1)
-  	{
-  		char *err_msg = "munmap(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  		exit(EXIT_FAILURE);
-  	}
+	unmap_segment(kitchen_room, kitchen_size());
+}
 
-  	if(close(fd_supp_cook) == -1)
-  	{
-  		char *err_msg = "close(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  		exit(EXIT_FAILURE);
-  	}
+void end_cook_stud(void)
+{
+	unmap_segment(counter_room, counter_size());
+}
 
-  	if(shm_unlink(SUPP_COOK) == -1)
-  	{
-  		char *err_msg = "shm_unlink(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  		exit(EXIT_FAILURE);
-  	}
+void *map_segment(const size_t size)
+{
+	/*
+	 * Actors are forked from this process, so an anonymous shared mapping reaches
+	 * all of them without a name: runs side by side cannot collide and a crashed
+	 * run leaves nothing behind. Threads and the simulation share the address
+	 * space, private memory is enough.
+	 */
+	int flags = (run_mode == MODE_PROCESSES) ? MAP_SHARED | MAP_ANONYMOUS : MAP_PRIVATE | MAP_ANONYMOUS;
+	void *segment = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if(segment == MAP_FAILED)
+	{
+		char *err_msg = "mmap(): unsuccessful!\n";
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
+		exit(EXIT_FAILURE);
+	}
+	return segment;
 }
 
-void end_cook_stud(const int fd_cook_stud)
+void unmap_segment(void *segment, const size_t size)
 {
-	if(munmap(counter_room, sizeof(Counter)) == -1)
+	if(munmap(segment, size) == -1)
   	{
   		char *err_msg = "munmap(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  		exit(EXIT_FAILURE);
-  	}
-
-  	if(close(fd_cook_stud) == -1)
-  	{
-  		char *err_msg = "close(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
-  		exit(EXIT_FAILURE);
-  	}
-
-  	if(shm_unlink(COOK_STUD) == -1)
-  	{
-  		char *err_msg = "shm_unlink(): unsuccessful!\n";
-		write(STDERR_FILENO, err_msg, sizeof(err_msg));
+		write(STDERR_FILENO, err_msg, strlen(err_msg));
   		exit(EXIT_FAILURE);
   	}
 }
 
 void handler(int sig)
 {
-	if (sig == SIGINT)
+	if (sig == SIGINT || sig == SIGTERM)
 	{
-		for(int i = 0; i < process_number; i++)
-    		kill(child_pids[i], SIGKILL);
-		free(child_pids);
+		if(run_mode == MODE_PROCESSES && actor_group > 0)
+			kill(-actor_group, SIGKILL);
+		kill_halls();
     	exit(EXIT_SUCCESS);
 	}
-}
\ No newline at end of file
+}
+
+MENU_INLINE void kitchen_items_courses(const int courses, int *items)
+{
+	for(int course = 0; course < courses; course++)
+		items[course] = ring_count(kitchen_ring(course));
+}
+
+void kitchen_items(int *items)
+{
+	MENU_SPECIALIZE(kitchen_items_courses, items);
+}
+
+int kitchen_count(void)
+{
+	int items[MENU_MAX];
+	kitchen_items(items);
+	int count = 0;
+	for(int course = 0; course < menu.count; course++)
+		count += items[course];
+	return count;
+}
+
+void hall_gauges(long long *kitchen, long long *at_counter)
+{
+	*kitchen = kitchen_count();
+	*at_counter = atomic_load_explicit(&counter_room->number_of_stud, memory_order_relaxed);
+}
+
+size_t kitchen_size(void)
+{
+	return sizeof(Kitchen) + menu.count * kitchen_stride() * sizeof(int);
+}
+
+size_t kitchen_stride(void)
+{
+	/* keeps the slots of each course on their own cache lines */
+	size_t per_line = CACHE_LINE / sizeof(int);
+	return (((size_t)K + per_line - 1) / per_line) * per_line;
+}
+
+int *kitchen_slots(const int course)
+{
+	return kitchen_room->slots + course * kitchen_stride();
+}
+
+Sync_Sem *kitchen_sem(const int course)
+{
+	return &kitchen_room->course_sem[course].sem;
+}
+
+Plate_Ring *kitchen_ring(const int course)
+{
+	return &kitchen_room->ring[course];
+}
+
+Counter_Shard *counter_shard(const int i)
+{
+	return &counter_room->shard[i];
+}
+
+Cook_Wait *cook_wait(const int number)
+{
+	return (Cook_Wait *)&counter_room->shard[shard_count] + (number - 1);
+}
+
+Tray_Wait *tray_wait(const int number)
+{
+	return (Tray_Wait *)cook_wait(N + 1) + number;
+}
+
+int *queue_ring(const int class)
+{
+	return (int *)tray_wait(M) + class * M;
+}
+
+size_t counter_size(void)
+{
+	return sizeof(Counter) + shard_count * sizeof(Counter_Shard) + N * sizeof(Cook_Wait) + M * sizeof(Tray_Wait) +
+		   classes * M * sizeof(int);
+}
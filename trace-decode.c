@@ -0,0 +1,312 @@
+/* Libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "program-events.h"
+#include "program-log.h"
+#include "program-trace.h"
+#include "program-menu.h"
+/* Libraries End*/
+
+/*
+ * Decoder of the binary event trace written with ./program --trace=DIR. Reads
+ * every trace file of the directories or files given, merges the records by
+ * timestamp and prints the event text of program-events.c, so the output is
+ * the log a --log=sync run would have written. The courses come from the menu
+ * file the run left in a trace directory, the default menu otherwise. With -j it also writes a
+ * Chrome trace_event JSON file: one process per role and one thread per
+ * actor, kitchen and counter items as counter tracks, and the tray, table
+ * and meal phases of every student as slices.
+ */
+
+/* Macro Constants */
+#define DECODE_USE_ERR "Usage: ./trace-decode [-q] [-j trace.json] DIR|FILE...\n"
+#define TRUE 1
+#define FALSE 0
+/* Macro Constants End */
+
+/* Structs */
+struct Trace_Entry
+{
+	Trace_Record record;
+	long long seq;					//order of the record in the input, keeps equal timestamps in file order
+};
+struct Trace_Set
+{
+	struct Trace_Entry *entries;
+	long long count;
+	long long capacity;
+};
+struct Student_Phase
+{
+	long long counter_ns;			//went to the counter, -1 if not waiting for a tray
+	long long got_ns;				//got a tray, -1 if not waiting for a table
+	long long sat_ns;				//sat down, -1 if not eating
+};
+/* Structs End */
+
+/* Typdefs */
+typedef struct Trace_Entry Trace_Entry;
+typedef struct Trace_Set Trace_Set;
+typedef struct Student_Phase Student_Phase;
+/* Typedefs End*/
+
+/* Global Variables */
+static const char *role_names[TRACE_ROLE_COUNT] = {"supplier", "cooks", "students"};
+static const char *code_names[TRACE_CODE_COUNT] = {"none", "supplier.going", "supplier.delivered", "supplier.done",
+		"cook.kitchen", "cook.going", "cook.placed", "cook.done", "student.counter", "student.got", "student.sat",
+		"student.left", "student.done"};
+/* Global Variables End */
+
+/* Function Declarations */
+void load_path(Trace_Set*, const char*);
+void load_file(Trace_Set*, const char*);
+int entry_compare(const void*, const void*);
+void print_text(const Trace_Set*);
+void write_items(FILE*, const Trace_Record*);
+void write_chrome(const Trace_Set*, const char*);
+/* Function Declarations End */
+
+int main(int argc, char *argv[])
+{
+	int is_quiet = FALSE;
+	char *json_path = NULL;
+
+	int option;
+	while((option = getopt(argc, argv, "qj:")) != -1)
+	{
+		switch (option)
+		{
+		case 'q':
+			is_quiet = TRUE;
+			break;
+		case 'j':
+			json_path = optarg;
+			break;
+		default:
+			fprintf(stderr, DECODE_USE_ERR);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if(optind == argc)
+	{
+		fprintf(stderr, DECODE_USE_ERR);
+		exit(EXIT_FAILURE);
+	}
+
+	menu_parse(MENU_DEFAULT);
+	Trace_Set set = {NULL, 0, 0};
+	for(int i = optind; i < argc; i++)
+		load_path(&set, argv[i]);
+	qsort(set.entries, set.count, sizeof(Trace_Entry), entry_compare);
+
+	if(!is_quiet)
+		print_text(&set);
+	if(json_path != NULL)
+		write_chrome(&set, json_path);
+	fprintf(stderr, "trace-decode: %lld events\n", set.count);
+
+	free(set.entries);
+	return EXIT_SUCCESS;
+}
+
+void load_path(Trace_Set *set, const char *path)
+{
+	struct stat st;
+	if(stat(path, &st) == -1)
+	{
+		fprintf(stderr, "stat(): unsuccessful for %s!\n", path);
+		exit(EXIT_FAILURE);
+	}
+	if(!S_ISDIR(st.st_mode))
+	{
+		load_file(set, path);
+		return;
+	}
+
+	menu_load(path);
+	/* files in name order, so ties between actors are broken the same way every time */
+	struct dirent **names;
+	int count = scandir(path, &names, NULL, alphasort);
+	if(count == -1)
+	{
+		fprintf(stderr, "scandir(): unsuccessful for %s!\n", path);
+		exit(EXIT_FAILURE);
+	}
+	for(int i = 0; i < count; i++)
+	{
+		size_t len = strlen(names[i]->d_name);
+		if(strncmp(names[i]->d_name, "trace-", 6) == 0 && len > 4 && strcmp(names[i]->d_name + len - 4, ".bin") == 0)
+		{
+			char file[4096];
+			snprintf(file, sizeof(file), "%s/%s", path, names[i]->d_name);
+			load_file(set, file);
+		}
+		free(names[i]);
+	}
+	free(names);
+}
+
+void load_file(Trace_Set *set, const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if(file == NULL)
+	{
+		fprintf(stderr, "fopen(): unsuccessful for %s!\n", path);
+		exit(EXIT_FAILURE);
+	}
+	Trace_Record record;
+	while(fread(&record, sizeof(record), 1, file) == 1)
+	{
+		/* an actor killed before trace_close() leaves the rest of its window zeroed */
+		if(record.code == TRACE_NONE || record.code >= TRACE_CODE_COUNT || record.role >= TRACE_ROLE_COUNT)
+			continue;
+		if(set->count == set->capacity)
+		{
+			set->capacity = (set->capacity == 0) ? TRACE_CHUNK : 2 * set->capacity;
+			set->entries = realloc(set->entries, set->capacity * sizeof(Trace_Entry));
+			if(set->entries == NULL)
+			{
+				fprintf(stderr, "realloc(): unsuccessful!\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		set->entries[set->count].record = record;
+		set->entries[set->count].seq = set->count;
+		set->count++;
+	}
+	fclose(file);
+}
+
+int entry_compare(const void *a, const void *b)
+{
+	const Trace_Entry *x = a;
+	const Trace_Entry *y = b;
+	if(x->record.time_ns != y->record.time_ns)
+		return (x->record.time_ns < y->record.time_ns) ? -1 : 1;
+	return (x->seq < y->seq) ? -1 : (x->seq > y->seq);
+}
+
+void print_text(const Trace_Set *set)
+{
+	log_init(LOG_BUFFERED, LOG_BACKEND_WRITE);
+	char line[LOG_LINE_SIZE];
+	for(long long i = 0; i < set->count; i++)
+		log_write(line, event_format(&set->entries[i].record, line, sizeof(line)));
+	log_flush();
+}
+
+static void write_slice(FILE *out, const char *name, const int tid, const long long start_ns, const long long end_ns,
+		const long long base_ns, const int round)
+{
+	fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"round\":%d}}",
+			name, TRACE_STUDENT, tid, (start_ns - base_ns) / 1000.0, (end_ns - start_ns) / 1000.0, round);
+}
+
+/* item counts keyed by the plate codes of the menu, closing the args object */
+void write_items(FILE *out, const Trace_Record *e)
+{
+	for(int course = 0; course < menu.count; course++)
+		fprintf(out, "%s\"%c\":%d", (course == 0) ? "" : ",", menu.code[course], e->items[course]);
+	fprintf(out, "}}");
+}
+
+void write_chrome(const Trace_Set *set, const char *path)
+{
+	FILE *out = fopen(path, "w");
+	if(out == NULL)
+	{
+		fprintf(stderr, "fopen(): unsuccessful for %s!\n", path);
+		exit(EXIT_FAILURE);
+	}
+
+	long long base_ns = (set->count > 0) ? set->entries[0].record.time_ns : 0;
+	int students = 0;
+	int cooks = 0;
+	for(long long i = 0; i < set->count; i++)
+	{
+		const Trace_Record *e = &set->entries[i].record;
+		if(e->role == TRACE_STUDENT && e->number + 1 > students)
+			students = e->number + 1;
+		if(e->role == TRACE_COOK && e->number > cooks)
+			cooks = e->number;
+	}
+	Student_Phase *phases = malloc((students + 1) * sizeof(Student_Phase));
+	if(phases == NULL)
+	{
+		fprintf(stderr, "malloc(): unsuccessful!\n");
+		exit(EXIT_FAILURE);
+	}
+	for(int i = 0; i < students; i++)
+		phases[i] = (Student_Phase){-1, -1, -1};
+
+	/* names of the roles and actors */
+	fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	for(int role = 0; role < TRACE_ROLE_COUNT; role++)
+		fprintf(out, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s\"}}",
+				(role == 0) ? "" : ",\n", role, role_names[role]);
+	fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"Supplier\"}}", TRACE_SUPPLIER);
+	for(int i = 1; i <= cooks; i++)
+		fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"Cook %d\"}}", TRACE_COOK, i, i);
+	for(int i = 0; i < students; i++)
+		fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"Student %d\"}}", TRACE_STUDENT, i, i);
+
+	for(long long i = 0; i < set->count; i++)
+	{
+		const Trace_Record *e = &set->entries[i].record;
+		double ts = (e->time_ns - base_ns) / 1000.0;
+		fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,"
+				"\"args\":{\"course\":%d,\"round\":%d,\"value\":%d,\"empty\":%d,",
+				code_names[e->code], e->role, e->number, ts, e->course, e->round, e->value, e->empty);
+		write_items(out, e);
+
+		switch (e->code)
+		{
+		case TRACE_SUPPLIER_GOING:
+		case TRACE_SUPPLIER_DELIVERED:
+		case TRACE_COOK_KITCHEN:
+			fprintf(out, ",\n{\"name\":\"kitchen\",\"ph\":\"C\",\"pid\":%d,\"ts\":%.3f,\"args\":{", TRACE_SUPPLIER, ts);
+			write_items(out, e);
+			break;
+		case TRACE_COOK_GOING:
+		case TRACE_COOK_PLACED:
+		case TRACE_STUDENT_COUNTER:
+			fprintf(out, ",\n{\"name\":\"counter\",\"ph\":\"C\",\"pid\":%d,\"ts\":%.3f,\"args\":{", TRACE_COOK, ts);
+			write_items(out, e);
+			if(e->code == TRACE_STUDENT_COUNTER)
+				phases[e->number].counter_ns = e->time_ns;
+			break;
+		case TRACE_STUDENT_GOT:
+			if(phases[e->number].counter_ns >= 0)
+				write_slice(out, "wait for tray", e->number, phases[e->number].counter_ns, e->time_ns, base_ns, e->round);
+			phases[e->number].counter_ns = -1;
+			phases[e->number].got_ns = e->time_ns;
+			break;
+		case TRACE_STUDENT_SAT:
+			if(phases[e->number].got_ns >= 0)
+				write_slice(out, "wait for table", e->number, phases[e->number].got_ns, e->time_ns, base_ns, e->round);
+			phases[e->number].got_ns = -1;
+			phases[e->number].sat_ns = e->time_ns;
+			break;
+		case TRACE_STUDENT_LEFT:
+		case TRACE_STUDENT_DONE:
+			if(phases[e->number].sat_ns >= 0)
+				write_slice(out, "eat", e->number, phases[e->number].sat_ns, e->time_ns, base_ns, e->round);
+			phases[e->number].sat_ns = -1;
+			break;
+		default:
+			break;
+		}
+	}
+	fprintf(out, "\n]}\n");
+
+	free(phases);
+	if(fclose(out) != 0)
+	{
+		fprintf(stderr, "fclose(): unsuccessful for %s!\n", path);
+		exit(EXIT_FAILURE);
+	}
+}